@@ -0,0 +1,132 @@
+#include "arena.hpp"
+#include "logging.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <memory>
+
+MeshArena::Stats MeshArena::stats;
+uint32_t MeshArena::generation = 0;
+
+// frees made since the last endFrame(), then batches of them waiting on
+// the fence placed at the end of their frame, oldest first.
+struct RetiringFrees {
+	GLsync fence;
+	std::vector<MeshAllocation> allocations;
+};
+static std::vector<std::unique_ptr<MeshArena>> arenas;
+static std::vector<MeshAllocation> frameFrees;
+static std::deque<RetiringFrees> retiring;
+
+MeshArena& MeshArena::get(const VertexFormat& format) {
+	for (auto& arena : arenas)
+		if (arena->format == format) return *arena;
+	arenas.push_back(std::make_unique<MeshArena>());
+	arenas.back()->format = format;
+	return *arenas.back();
+}
+
+void MeshArena::addBlock(uint32_t vertexCount, uint32_t indexUnits) {
+	vertexCount = std::max<uint32_t>(vertexCount,
+		vertexBlockSize / format.stride);
+	indexUnits = std::max<uint32_t>(indexUnits, indexBlockSize / 4);
+	ArenaBlock block;
+	glGenVertexArrays(1, &block.VAO);
+	glGenBuffers(1, &block.VBO);
+	glGenBuffers(1, &block.EBO);
+	glState.bindVertexArray(block.VAO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, block.VBO);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCount * format.stride,
+		nullptr, GL_STATIC_DRAW);
+	glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, block.EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexUnits * 4, nullptr,
+		GL_STATIC_DRAW);
+	format.apply();
+	block.vertices = OffsetAllocator::create(vertexCount);
+	block.indices = OffsetAllocator::create(indexUnits);
+	blocks.push_back(std::move(block));
+	++stats.blocks;
+	LOG("MeshArena::addBlock: %u vertices of %d bytes, %u index bytes\n",
+		vertexCount, format.stride, indexUnits * 4);
+}
+
+MeshAllocation MeshArena::allocate(const void* vertices, uint32_t vertexCount,
+	const void* indices, size_t indexBytes) {
+	uint32_t indexUnits = (indexBytes + 3) / 4;
+	MeshAllocation out;
+	// first fit over the blocks, a new block is always big enough.
+	for (uint32_t b = 0; !out; ++b) {
+		if (b == blocks.size()) addBlock(vertexCount, indexUnits);
+		auto& block = blocks[b];
+		auto v = block.vertices.allocate(vertexCount);
+		if (!v) continue;
+		auto i = block.indices.allocate(indexUnits);
+		if (!i) {
+			block.vertices.free(v);
+			continue;
+		}
+		out = {this, generation, b, v, i, (GLint)v.offset,
+			(GLintptr)i.offset * 4};
+	}
+	auto& block = blocks[out.block];
+	glState.bindBuffer(GL_ARRAY_BUFFER, block.VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)out.baseVertex * format.stride,
+		(GLsizeiptr)vertexCount * format.stride, vertices);
+	// the EBO is VAO state, binding it through the block's VAO keeps other
+	// VAOs untouched.
+	glState.bindVertexArray(block.VAO);
+	glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, block.EBO);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, out.indexOffset, indexBytes,
+		indices);
+	++stats.allocations;
+	return out;
+}
+
+void MeshArena::free(const MeshAllocation& allocation) {
+	if (!allocation || allocation.generation != generation) return;
+	frameFrees.push_back(allocation);
+	++stats.pending;
+}
+
+void MeshArena::endFrame() {
+	if (!frameFrees.empty()) {
+		retiring.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+			std::move(frameFrees)});
+		frameFrees.clear();
+	}
+	// fences signal in order, the first unsignaled one ends the scan.
+	while (!retiring.empty()) {
+		auto& batch = retiring.front();
+		GLenum status = glClientWaitSync(batch.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(batch.fence);
+		for (auto& allocation : batch.allocations) {
+			auto& block = allocation.arena->blocks[allocation.block];
+			block.vertices.free(allocation.vertices);
+			block.indices.free(allocation.indices);
+		}
+		stats.pending -= batch.allocations.size();
+		retiring.pop_front();
+	}
+}
+
+void MeshArena::destroyAll() {
+	for (auto& batch : retiring) glDeleteSync(batch.fence);
+	retiring.clear();
+	frameFrees.clear();
+	for (auto& arena : arenas) {
+		for (auto& block : arena->blocks) {
+			glDeleteVertexArrays(1, &block.VAO);
+			glDeleteBuffers(1, &block.VBO);
+			glDeleteBuffers(1, &block.EBO);
+			glState.forgetVertexArray(block.VAO);
+			glState.forgetBuffer(block.VBO);
+			glState.forgetBuffer(block.EBO);
+		}
+	}
+	arenas.clear();
+	stats = {};
+	++generation;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "glstate.hpp"
+#include "offsetalloc.hpp"
+#include "vertexformat.hpp"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+struct MeshArena;
+
+// a vertex buffer and an index buffer behind one VAO, suballocated in
+// vertices and in 4 byte index units, which keeps both index types aligned.
+struct ArenaBlock {
+	GLuint VAO = 0, VBO = 0, EBO = 0;
+	OffsetAllocator vertices, indices;
+};
+
+// where one mesh lives in its arena. draws pass baseVertex and indexOffset
+// to glDrawElementsBaseVertex.
+struct MeshAllocation {
+	MeshArena* arena = nullptr;
+	// MeshArena::generation when allocated. a new arena can reuse the
+	// address of one destroyAll() deleted, this tells them apart.
+	uint32_t generation = 0;
+	uint32_t block = 0;
+	OffsetAllocator::Allocation vertices, indices;
+	GLint baseVertex = 0;
+	// in bytes, into the block's EBO.
+	GLintptr indexOffset = 0;
+	explicit operator bool() const { return arena; }
+};
+
+// Large buffers shared by every mesh of one VertexFormat, so all of them
+// draw from the same VAO and switching meshes is only a change of draw
+// arguments. Blocks are added as they fill up, one mesh never spans two.
+//
+// Ranges given back with free() may still be read by queued draws, so they
+// are only reused once endFrame() has seen the fence placed after them
+// signal.
+struct MeshArena {
+	static constexpr GLsizeiptr vertexBlockSize = 16 << 20,
+		indexBlockSize = 4 << 20;
+	struct Stats {
+		unsigned long allocations = 0, blocks = 0;
+		// ranges freed but not yet reusable.
+		unsigned long pending = 0;
+	};
+	static Stats stats;
+	// bumped by destroyAll().
+	static uint32_t generation;
+	VertexFormat format;
+	std::vector<ArenaBlock> blocks;
+
+	// the arena for format, created on first use. stays valid until
+	// destroyAll().
+	static MeshArena& get(const VertexFormat& format);
+	// copies vertexCount vertices, already encoded in format, and
+	// indexBytes of packed indices into a new range.
+	MeshAllocation allocate(const void* vertices, uint32_t vertexCount,
+		const void* indices, size_t indexBytes);
+	MeshAllocation allocate(const std::vector<uint8_t>& vertices,
+		const IndexData& indices) {
+		return allocate(vertices.data(), vertices.size() / format.stride,
+			indices.bytes.data(), indices.bytes.size());
+	}
+	// deferred until the GPU is done with the frame, see endFrame().
+	// allocations from arenas already destroyed are ignored.
+	static void free(const MeshAllocation& allocation);
+	// fences the frame's frees and recycles ranges whose fence signaled.
+	// call once per frame, after the frame's draws are issued.
+	static void endFrame();
+	// deletes every arena's GL objects, with the context still current.
+	static void destroyAll();
+
+private:
+	void addBlock(uint32_t vertexCount, uint32_t indexUnits);
+};
@@ -0,0 +1,143 @@
+#include "atlas.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+// packs every image padded by padding on each side, tallest first. returns
+// how many fit; rects of the ones that didn't are left empty.
+static int packAll(SkylinePacker& packer, const std::vector<AtlasImage>& images,
+	int padding, std::vector<AtlasRect>& rects) {
+	std::vector<size_t> order(images.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return images[a].height > images[b].height;
+	});
+	rects.assign(images.size(), {0, 0, 0, 0});
+	int packed = 0;
+	for (size_t i : order) {
+		auto& image = images[i];
+		if (!image.pixels || image.width <= 0 || image.height <= 0) continue;
+		if (packer.pack(image.width + 2 * padding,
+			image.height + 2 * padding, rects[i]))
+			packed++;
+	}
+	return packed;
+}
+
+TextureAtlas TextureAtlas::create(const std::vector<AtlasImage>& images,
+	GLenum unitIndex, int padding, int maxSize) {
+	TextureAtlas out;
+	out.padding = padding = std::max(padding, 0);
+	out.stats.images = images.size();
+
+	long area = 0;
+	int widest = 1, tallest = 1, valid = 0;
+	for (auto& image : images) {
+		if (!image.pixels || image.width <= 0 || image.height <= 0) continue;
+		int w = image.width + 2 * padding, h = image.height + 2 * padding;
+		area += (long)w * h;
+		widest = std::max(widest, w);
+		tallest = std::max(tallest, h);
+		valid++;
+	}
+
+	// power of two sizes, square or twice as wide, grown until everything
+	// fits or both sides reach maxSize.
+	int width = 1, height = 1;
+	auto full = [&] { return width >= maxSize && height >= maxSize; };
+	auto grow = [&] {
+		if ((height < width || width >= maxSize) && height < maxSize)
+			height *= 2;
+		else
+			width *= 2;
+	};
+	while (!full() && (width < widest || height < tallest
+		|| (long)width * height < area)) {
+		if (width < widest && width < maxSize) width *= 2;
+		else if (height < tallest && height < maxSize) height *= 2;
+		else grow();
+	}
+	SkylinePacker packer;
+	std::vector<AtlasRect> rects;
+	for (;;) {
+		width = std::min(width, maxSize);
+		height = std::min(height, maxSize);
+		packer = SkylinePacker::create(width, height);
+		out.stats.packed = packAll(packer, images, padding, rects);
+		if (out.stats.packed == valid || full()) break;
+		grow();
+	}
+	if (out.stats.packed < valid)
+		std::cout << "TextureAtlas: " << valid - out.stats.packed
+			<< " images don't fit in " << maxSize << "x" << maxSize << '\n';
+	out.width = width;
+	out.height = height;
+	out.stats.occupancy = packer.occupancy();
+
+	// each rect gets its image with the edge pixels smeared into the
+	// padding around it.
+	std::vector<unsigned char> pixels((size_t)width * height * 4);
+	out.regions.assign(images.size(), {glm::vec2(0.f), glm::vec2(0.f)});
+	for (size_t i = 0; i < images.size(); ++i) {
+		auto& image = images[i];
+		auto& rect = rects[i];
+		if (!rect.width) continue;
+		for (int dy = 0; dy < rect.height; ++dy) {
+			int sy = std::clamp(dy - padding, 0, image.height - 1);
+			for (int dx = 0; dx < rect.width; ++dx) {
+				int sx = std::clamp(dx - padding, 0, image.width - 1);
+				size_t to = (size_t)(rect.y + dy) * width + rect.x + dx;
+				std::copy_n(image.pixels + ((size_t)sy * image.width + sx) * 4,
+					4, &pixels[to * 4]);
+			}
+		}
+		out.regions[i] = {
+			glm::vec2(rect.x + padding, rect.y + padding)
+				/ glm::vec2(width, height),
+			glm::vec2(image.width, image.height) / glm::vec2(width, height)};
+	}
+
+	// level n sees padding >> n pixels around each image.
+	GLsizei levels = 1;
+	for (int p = padding; p > 1; p /= 2) levels++;
+	levels = std::min(levels, Texture::levelsFor(width, height));
+	auto format = PixelFormat::forChannels(4);
+	out.texture = Texture::generate(unitIndex);
+	out.texture.bind()
+		.allocate(width, height, format, levels)
+		.upload(pixels.data(), width, height, format);
+	if (levels > 1) glGenerateMipmap(GL_TEXTURE_2D);
+	Texture::setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	Texture::setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	Texture::setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	Texture::setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	out.texture.unbind();
+	return out;
+}
+
+TextureAtlas TextureAtlas::fromPaths(const std::vector<const char*>& imagePaths,
+	GLenum unitIndex, int padding, int maxSize) {
+	std::vector<AtlasImage> images;
+	for (auto path : imagePaths) {
+		AtlasImage image{};
+		int channels;
+		image.pixels = stbi_load(path, &image.width, &image.height, &channels,
+			4);
+		if (!image.pixels)
+			std::cout << "Failed to load texture " << path << '\n';
+		images.push_back(image);
+	}
+	auto out = create(images, unitIndex, padding, maxSize);
+	for (auto& image : images) stbi_image_free((void*)image.pixels);
+	return out;
+}
+
+void remapTexCoords(std::vector<float>& vertices, size_t stride,
+	const AtlasRegion& region, size_t uvOffset) {
+	for (size_t i = uvOffset; i + 1 < vertices.size(); i += stride) {
+		auto uv = region.remap(glm::vec2(vertices[i], vertices[i + 1]));
+		vertices[i] = uv.x;
+		vertices[i + 1] = uv.y;
+	}
+}
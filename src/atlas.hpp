@@ -0,0 +1,57 @@
+#pragma once
+
+#include "glm.hpp"
+#include "skyline.hpp"
+#include "texture.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// where one image ended up, as a transform of its texture coordinates:
+// uv' = offset + uv * scale.
+struct AtlasRegion {
+	glm::vec2 offset, scale;
+	glm::vec2 remap(glm::vec2 uv) const { return offset + uv * scale; }
+};
+
+// RGBA8, rows in the order they're uploaded in.
+struct AtlasImage {
+	const unsigned char* pixels;
+	int width, height;
+};
+
+// Many small images packed into one RGBA8 texture. Each image is
+// surrounded by padding pixels copied from its edges, so filtering and the
+// first mip levels don't bleed its neighbours in; the mip chain stops at
+// the level where the padding shrinks below a pixel. Texture coordinates
+// have to stay in [0, 1], repeating doesn't work inside an atlas.
+struct TextureAtlas {
+	struct Stats {
+		int images, packed;
+		float occupancy;
+	};
+
+	Texture texture;
+	int width = 0, height = 0, padding = 0;
+	// one per image, in the order given. images that didn't fit get an
+	// empty region.
+	std::vector<AtlasRegion> regions;
+	Stats stats{};
+
+	// packs images into the smallest power of two square (or 2:1) atlas
+	// up to maxSize that holds them all, or as many as fit at maxSize.
+	static TextureAtlas create(const std::vector<AtlasImage>& images,
+		GLenum unitIndex, int padding = 4, int maxSize = 4096);
+	// decodes the images at imagePaths first. unreadable files get an
+	// empty region.
+	static TextureAtlas fromPaths(const std::vector<const char*>& imagePaths,
+		GLenum unitIndex, int padding = 4, int maxSize = 4096);
+	operator bool() const { return texture.id; }
+};
+
+// rewrites the texture coordinates of interleaved float vertices (like
+// Mesh::create takes) into region, uvOffset floats into each vertex.
+void remapTexCoords(std::vector<float>& vertices, size_t stride,
+	const AtlasRegion& region, size_t uvOffset = 3);
@@ -0,0 +1,110 @@
+#include "skyline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Skyline packing benchmark: packs sets of random rectangles, tallest
+// first like TextureAtlas does, into a size x size area and prints the
+// time and occupancy per set as JSON. Every placement is checked: inside
+// the area, overlapping no other, and occupancy() has to match the packed
+// area. Needs no GL.
+//
+// usage: atlasbench [--rects n] [--size n] [--seed n]
+
+using Clock = std::chrono::steady_clock;
+
+struct RectSet {
+	const char* name;
+	int minSide, maxSide;
+	// height equals width.
+	bool square;
+};
+
+int main(int argc, char** argv) {
+	int rects = 4000, size = 2048;
+	unsigned seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		#define arg(x) (!strcmp(argv[i], x))
+		if arg("--rects") rects = atoi(argv[i+1]);
+		else if arg("--size") size = atoi(argv[i+1]);
+		else if arg("--seed") seed = atoi(argv[i+1]);
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+		#undef arg
+	}
+
+	const RectSet sets[] = {
+		{"icons", 16, 16, true},
+		{"small", 4, 48, false},
+		{"mixed", 8, 160, false},
+	};
+	std::mt19937 rng(seed);
+	std::vector<unsigned char> covered;
+	bool failed = false;
+	printf("{\n\t\"rects\": %d,\n\t\"size\": %d,\n\t\"sets\": [\n", rects,
+		size);
+	for (auto& set : sets) {
+		std::uniform_int_distribution<int> side(set.minSide, set.maxSide);
+		std::vector<AtlasRect> wanted(rects);
+		for (auto& rect : wanted) {
+			rect.width = side(rng);
+			rect.height = set.square ? rect.width : side(rng);
+		}
+		std::stable_sort(wanted.begin(), wanted.end(),
+			[](const AtlasRect& a, const AtlasRect& b) {
+				return a.height > b.height;
+			});
+
+		auto start = Clock::now();
+		auto packer = SkylinePacker::create(size, size);
+		std::vector<AtlasRect> placed;
+		for (auto& rect : wanted) {
+			AtlasRect out;
+			if (packer.pack(rect.width, rect.height, out))
+				placed.push_back(out);
+		}
+		double ms = std::chrono::duration<double, std::milli>(
+			Clock::now() - start).count();
+
+		covered.assign((size_t)size * size, 0);
+		long area = 0;
+		for (auto& rect : placed) {
+			if (rect.x < 0 || rect.y < 0 || rect.x + rect.width > size
+				|| rect.y + rect.height > size) {
+				fprintf(stderr, "%s: rect at %d,%d out of bounds\n", set.name,
+					rect.x, rect.y);
+				failed = true;
+				continue;
+			}
+			for (int y = rect.y; y < rect.y + rect.height; ++y)
+				for (int x = rect.x; x < rect.x + rect.width; ++x)
+					if (covered[(size_t)y * size + x]++) {
+						fprintf(stderr, "%s: overlap at %d,%d\n", set.name,
+							x, y);
+						failed = true;
+						y = rect.y + rect.height;
+						break;
+					}
+			area += (long)rect.width * rect.height;
+		}
+		float occupancy = (float)area / ((long)size * size);
+		if (packer.used != area || packer.occupancy() != occupancy) {
+			fprintf(stderr, "%s: occupancy %f, packed area gives %f\n",
+				set.name, packer.occupancy(), occupancy);
+			failed = true;
+		}
+		printf("%s\t\t{\"set\": \"%s\", \"packed\": %zu, "
+			"\"occupancy\": %.4f, \"ms\": %.3f}", &set == sets ? "" : ",\n",
+			set.name,
+			placed.size(), packer.occupancy(), ms);
+	}
+	printf("\n\t]\n}\n");
+	return failed ? 1 : 0;
+}
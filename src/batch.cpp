@@ -0,0 +1,129 @@
+#include "batch.hpp"
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+GLuint MeshBatch::add(const std::vector<float>& vertices,
+	const std::vector<int>& indices) {
+	const size_t floatsPerVertex = 5;
+	BatchRange range;
+	range.firstIndex = this->indices.size();
+	range.indexCount = indices.size();
+	range.baseVertex = this->vertices.size() / floatsPerVertex;
+	maxVertices = std::max(maxVertices, vertices.size() / floatsPerVertex);
+	this->vertices.insert(this->vertices.end(), vertices.begin(),
+		vertices.end());
+	this->indices.insert(this->indices.end(), indices.begin(), indices.end());
+	ranges.push_back(range);
+	return ranges.size() - 1;
+}
+
+GLuint MeshBatch::add(const Mesh& mesh) {
+	assert(mesh.storage == MeshStorage::keep);
+	return add(mesh.vertices, mesh.indices);
+}
+
+void MeshBatch::upload() {
+	auto packed = format.encode(vertices);
+	auto packedIndices = IndexData::pack(indices, maxVertices);
+	indexType = packedIndices.type;
+	if (!VAO) {
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+	}
+	glState.bindVertexArray(VAO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+	glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, packedIndices.bytes.size(),
+		packedIndices.bytes.data(), GL_STATIC_DRAW);
+	format.apply();
+
+	if (stream.buffer) {
+		glState.bindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+		InstanceData::setAttribs();
+	}
+}
+
+void MeshBatch::reserve(GLsizei count) {
+	// room for both arrays plus their alignment padding.
+	GLsizeiptr size = count * (sizeof(InstanceData)
+		+ sizeof(DrawElementsIndirectCommand)) + sizeof(InstanceData) + 4;
+	if (size <= stream.regionSize) return;
+	if (stream.buffer) {
+		// the old regions may still be read by queued draws.
+		glFinish();
+		stream.destroy();
+	}
+	stream = StreamBuffer::create(GL_ARRAY_BUFFER, size * 2);
+	glState.bindVertexArray(VAO);
+	InstanceData::setAttribs();
+}
+
+void MeshBatch::begin(GLsizei capacity) {
+	count = 0;
+	commands.clear();
+	this->capacity = std::max(capacity, 0);
+	reserve(std::max(this->capacity, 1));
+	stream.beginFrame();
+	// instance attributes point at the start of the stream, so an aligned
+	// offset turns into a baseInstance.
+	GLintptr instanceOffset = 0;
+	instancesOut = (InstanceData*)stream.allocate(
+		this->capacity * sizeof(InstanceData), sizeof(InstanceData),
+		&instanceOffset);
+	firstInstance = instanceOffset / sizeof(InstanceData);
+	commandsOut = (DrawElementsIndirectCommand*)stream.allocate(
+		this->capacity * sizeof(DrawElementsIndirectCommand), 4,
+		&commandOffset);
+}
+
+void MeshBatch::submit(GLuint range, const glm::mat4& transform,
+	GLuint texIndex) {
+	assert(count < capacity);
+	if (count >= capacity) return;
+	const BatchRange& r = ranges[range];
+	DrawElementsIndirectCommand command{r.indexCount, 1, r.firstIndex,
+		r.baseVertex, firstInstance + count};
+	instancesOut[count] = {transform, texIndex};
+	commandsOut[count] = command;
+	if (!GLEXT_multi_draw_indirect) commands.push_back(command);
+	++count;
+}
+
+int MeshBatch::draw(const Material& material) {
+	stats = {};
+	if (!capacity) return 0;
+	// fences the region begin() started even when nothing gets drawn.
+	if (!count || !supported()) {
+		stream.endFrame();
+		capacity = 0;
+		return 0;
+	}
+	stream.flush();
+
+	material.bind();
+	glState.setBlend(false);
+	glState.bindVertexArray(VAO);
+	stats.commands = count;
+	if (GLEXT_multi_draw_indirect) {
+		glState.bindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.buffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, indexType,
+			(GLvoid*)commandOffset, count, 0);
+		stats.draws = 1;
+	} else {
+		for (auto& command : commands)
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES,
+				command.count, indexType,
+				(GLvoid*)(uintptr_t)(command.firstIndex * IndexData::size(indexType)),
+				command.instanceCount, command.baseVertex,
+				command.baseInstance);
+		stats.draws = count;
+	}
+	stream.endFrame();
+	// the region is the GPU's now, the next frame starts with begin().
+	capacity = count = 0;
+	return stats.draws;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "glm.hpp"
+#include "glext.hpp"
+#include "glstate.hpp"
+#include "instancing.hpp"
+#include "stream.hpp"
+#include "vertexformat.hpp"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+struct Mesh;
+struct Material;
+
+// layout glMultiDrawElementsIndirect reads from DRAW_INDIRECT_BUFFER.
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+// where one mesh lives inside a MeshBatch's shared buffers.
+struct BatchRange {
+	GLuint firstIndex;
+	GLuint indexCount;
+	GLint baseVertex;
+};
+
+// Packs meshes of the Mesh vertex layout (5 floats) into one vertex and one
+// index buffer behind a single VAO, stored in format and with 16 bit
+// indices when every mesh has few enough vertices, and draws every submitted object with
+// one glMultiDrawElementsIndirect. each command's baseInstance selects the
+// object's InstanceData, so it's drawn with the instanced shaders. needs
+// GL 4.2 for baseInstance; without GL 4.3 the commands are issued one by one.
+// submit() writes instances and commands straight into a StreamBuffer,
+// which also serves as the DRAW_INDIRECT_BUFFER.
+struct MeshBatch {
+	struct Stats {
+		int draws, commands;
+	} stats{};
+	GLuint VAO=0, VBO=0, EBO=0;
+	// set before upload(). positions can't be normalized, there's no
+	// per-mesh decode transform.
+	VertexFormat format = VertexFormat::compact();
+	GLenum indexType = GL_UNSIGNED_INT;
+	StreamBuffer stream;
+	std::vector<BatchRange> ranges;
+
+	static bool supported() { return GLEXT_base_instance; }
+	// appends geometry before upload(), returns the range index.
+	GLuint add(const std::vector<float>& vertices,
+		const std::vector<int>& indices);
+	// the mesh has to keep its data, see MeshStorage::keep.
+	GLuint add(const Mesh& mesh);
+	// creates the GL buffers from everything added so far.
+	void upload();
+	// starts the frame's stream region with room for capacity submits,
+	// the ones past it are dropped.
+	void begin(GLsizei capacity);
+	void submit(GLuint range, const glm::mat4& transform,
+		GLuint texIndex = 0);
+	// draws everything submitted since begin(), once; returns the number
+	// of GL draw calls made.
+	int draw(const Material& material);
+
+private:
+	std::vector<float> vertices;
+	std::vector<int> indices;
+	// vertices of the largest mesh, which decides the index type.
+	size_t maxVertices = 0;
+	// this frame's part of the stream, see begin().
+	InstanceData* instancesOut = nullptr;
+	DrawElementsIndirectCommand* commandsOut = nullptr;
+	GLsizei capacity = 0, count = 0;
+	GLintptr commandOffset = 0;
+	GLuint firstInstance = 0;
+	// a copy of the commands for drawing them one by one, only kept
+	// without multi-draw indirect.
+	std::vector<DrawElementsIndirectCommand> commands;
+	// recreates the stream so each region fits count objects.
+	void reserve(GLsizei count);
+};
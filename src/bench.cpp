@@ -0,0 +1,366 @@
+#include "bvh.hpp"
+#include "headless.hpp"
+#include "occlusion.hpp"
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Frame-time benchmark: drives Renderer::process headless for a fixed number
+// of frames and prints CPU and glFinish-synchronized frame times as JSON.
+//
+// usage: bench [--scene name] [--frames n] [--warmup n] [--width w]
+//              [--height h] [--instances n] [--out file.json]
+
+using Clock = std::chrono::steady_clock;
+
+struct Stats {
+	double min, p50, p95, p99, max, mean;
+	// takes samples by value, they get sorted.
+	static Stats compute(std::vector<double> samples) {
+		Stats out{};
+		if (samples.empty()) return out;
+		std::sort(samples.begin(), samples.end());
+		auto percentile = [&](double p) {
+			size_t i = (size_t)(p * (samples.size() - 1) + .5);
+			return samples[std::min(i, samples.size() - 1)];
+		};
+		out.min = samples.front();
+		out.max = samples.back();
+		out.p50 = percentile(.50);
+		out.p95 = percentile(.95);
+		out.p99 = percentile(.99);
+		double sum = 0.;
+		for (double s : samples) sum += s;
+		out.mean = sum / samples.size();
+		return out;
+	}
+	void print(FILE* file, const char* name) const {
+		fprintf(file, "\t\t\"%s\": {\"min\": %.6f, \"p50\": %.6f, "
+			"\"p95\": %.6f, \"p99\": %.6f, \"max\": %.6f, \"mean\": %.6f}",
+			name, min, p50, p95, p99, max, mean);
+	}
+};
+
+struct Scene {
+	const char* name;
+	void (*setup)(Renderer& r);
+	void (*update)(Renderer& r, int frame);
+};
+
+static int instanceCount = 100000;
+
+static void lookAtCube(Renderer& r, glm::vec3 pos) {
+	r.cameraU.data = Camera::_fromDir(pos, glm::vec3(.3f, .3f, .5f) - pos);
+}
+
+// a unit square facing +z, in the same vertex format as cubeMesh().
+static const std::vector<float> squareVertices = {
+	-.5f, -.5f, 0.f,	0.f, 0.f,
+	.5f,  -.5f, 0.f,	1.f, 0.f,
+	-.5f,  .5f, 0.f,	0.f, 1.f,
+	.5f,   .5f, 0.f,	1.f, 1.f,
+};
+static const std::vector<int> squareIndices = {0, 1, 2, 1, 3, 2};
+
+// the cube, the square and a pyramid.
+static void addShapes(MeshBatch& batch) {
+	batch.add(cubeMesh(MeshStorage::keep));
+	batch.add(squareVertices, squareIndices);
+	batch.add({
+		-.5f, 0.f, -.5f,	0.f, 0.f,
+		.5f,  0.f, -.5f,	1.f, 0.f,
+		-.5f, 0.f,  .5f,	0.f, 1.f,
+		.5f,  0.f,  .5f,	1.f, 1.f,
+		0.f,  1.f,  0.f,	.5f, .5f,
+	}, {0, 1, 2, 1, 3, 2, 0, 1, 4, 1, 3, 4, 3, 2, 4, 2, 0, 4});
+	batch.upload();
+}
+
+// object bounds and occluders have to include the shaders' offset.
+static const glm::mat4 offsetTransform =
+	glm::translate(glm::mat4(1.f), shaderOffset);
+
+// box around all three shapes, as drawn with transform.
+static Aabb shapeBounds(const glm::mat4& transform) {
+	return Aabb{glm::vec3(-.5f), glm::vec3(.8f, 1.f, 1.f)}
+		.transformed(transform * offsetTransform);
+}
+
+// instanceCount cubes on a 3d grid centered on the origin, alternating
+// textures.
+static std::vector<InstanceData> cubeField(float spacing) {
+	int side = (int)glm::ceil(glm::pow((float)instanceCount, 1.f/3.f));
+	float half = (side - 1) * spacing / 2.f;
+	std::vector<InstanceData> out;
+	out.reserve(instanceCount);
+	for (int i = 0; i < instanceCount; ++i) {
+		int x = i % side, y = i / side % side, z = i / (side * side);
+		auto pos = glm::vec3(x, y, z) * spacing - glm::vec3(half);
+		out.push_back({glm::translate(glm::mat4(1.f), pos), (GLuint)(i & 1)});
+	}
+	return out;
+}
+
+static const Scene scenes[] = {
+	// camera never moves.
+	{ "static",
+		[](Renderer& r) { lookAtCube(r, glm::vec3(.3f, .3f, 3.5f)); },
+		[](Renderer&, int) {} },
+	// camera circles the cube, so the view changes every frame.
+	{ "orbit",
+		[](Renderer& r) { lookAtCube(r, glm::vec3(.3f, .3f, 3.5f)); },
+		[](Renderer& r, int frame) {
+			float theta = frame * glm::radians(1.f);
+			lookAtCube(r, glm::vec3(.3f + 3.f * glm::sin(theta), .3f,
+				.5f + 3.f * glm::cos(theta)));
+		} },
+	// --instances cubes in one instanced draw, seen from outside the field.
+	{ "cubes",
+		[](Renderer& r) {
+			r.addInstanced(cubeMesh(), cubeField(1.2f));
+			r.cameraU.data = Camera::_fromDir(glm::vec3(0.f, 0.f, 60.f),
+				glm::vec3(0.f, 0.f, -1.f));
+		},
+		[](Renderer&, int) {} },
+	// --instances objects cycling through three meshes, packed into one
+	// MeshBatch and drawn by a single multi-draw, resubmitted every frame.
+	{ "batch",
+		[](Renderer& r) {
+			addShapes(r.batches.emplace_back());
+			r.cameraU.data = Camera::_fromDir(glm::vec3(0.f, 0.f, 60.f),
+				glm::vec3(0.f, 0.f, -1.f));
+		},
+		[](Renderer& r, int) {
+			static auto field = cubeField(1.2f);
+			auto& batch = r.batches[0];
+			batch.begin(field.size());
+			for (size_t i = 0; i < field.size(); ++i)
+				batch.submit(i % batch.ranges.size(), field[i].transform,
+					field[i].texIndex);
+		} },
+	// the batch scene seen from inside the field while turning around, only
+	// objects whose bounding sphere touches the frustum are submitted.
+	{ "culled",
+		[](Renderer& r) {
+			addShapes(r.batches.emplace_back());
+			r.cameraU.data = Camera::_fromDir(glm::vec3(0.f),
+				glm::vec3(0.f, 0.f, -1.f));
+		},
+		[](Renderer& r, int frame) {
+			static auto field = cubeField(1.2f);
+			static SphereBounds bounds;
+			static std::vector<uint32_t> visible(field.size());
+			if (bounds.size() != field.size())
+				for (auto& instance : field)
+					bounds.push(shapeBounds(instance.transform).center(), 1.25f);
+			float theta = frame * glm::radians(1.f);
+			r.cameraU.data = Camera::_fromDir(glm::vec3(0.f),
+				glm::vec3(glm::sin(theta), 0.f, -glm::cos(theta)));
+			size_t count = cullSpheres(r.frustum(), bounds, visible.data());
+			auto& batch = r.batches[0];
+			batch.begin(count);
+			for (size_t i = 0; i < count; ++i) {
+				auto& instance = field[visible[i]];
+				batch.submit(visible[i] % batch.ranges.size(),
+					instance.transform, instance.texIndex);
+			}
+		} },
+	// the culled scene with every eighth object bobbing up and down. moved
+	// objects are refitted into a Bvh that does the culling, and the object
+	// under the screen center is picked by a ray and drawn with the other
+	// texture.
+	{ "dynamic",
+		[](Renderer& r) {
+			addShapes(r.batches.emplace_back());
+			r.cameraU.data = Camera::_fromDir(glm::vec3(0.f),
+				glm::vec3(0.f, 0.f, -1.f));
+		},
+		[](Renderer& r, int frame) {
+			static auto field = cubeField(1.2f);
+			static Bvh bvh;
+			static std::vector<uint32_t> visible;
+			if (bvh.bounds.size() != field.size()) {
+				std::vector<Aabb> bounds;
+				for (auto& instance : field)
+					bounds.push_back(shapeBounds(instance.transform));
+				bvh = Bvh::build(std::move(bounds));
+			}
+			for (size_t i = frame & 7; i < field.size(); i += 8) {
+				auto& transform = field[i].transform;
+				transform[3].y += glm::sin(frame * .1f + i) * .05f;
+				bvh.update(i, shapeBounds(transform));
+			}
+			float theta = frame * glm::radians(1.f);
+			auto dir = glm::vec3(glm::sin(theta), 0.f, -glm::cos(theta));
+			r.cameraU.data = Camera::_fromDir(glm::vec3(0.f), dir);
+			Bvh::Hit hit{};
+			bool picked = bvh.raycast(glm::vec3(0.f), dir, 100.f, hit);
+			visible.clear();
+			bvh.cull(r.frustum(), visible);
+			auto& batch = r.batches[0];
+			batch.begin(visible.size());
+			for (uint32_t i : visible) {
+				auto& instance = field[i];
+				batch.submit(i % batch.ranges.size(), instance.transform,
+					instance.texIndex ^ (picked && i == hit.object));
+			}
+		} },
+	// the field behind a wall that hides most of it, with the camera
+	// swaying sideways so objects come into view around the edges. the
+	// wall is rasterized into an OcclusionBuffer and every object surviving
+	// the frustum is tested against it before submission.
+	{ "occluded",
+		[](Renderer& r) {
+			addShapes(r.batches.emplace_back());
+		},
+		[](Renderer& r, int frame) {
+			static auto field = cubeField(1.2f);
+			static Bvh bvh;
+			static auto occlusion = OcclusionBuffer::create();
+			static std::vector<uint32_t> visible;
+			if (bvh.bounds.size() != field.size()) {
+				std::vector<Aabb> bounds;
+				for (auto& instance : field)
+					bounds.push_back(shapeBounds(instance.transform));
+				bvh = Bvh::build(std::move(bounds));
+			}
+			float half = bvh.bounds.empty() ? 1.f : -bvh.bounds[0].min.z;
+			// scaled with the field, and moved against the shader offset so
+			// it's drawn centered.
+			float size = half * 1.5f;
+			auto wall = glm::scale(glm::translate(glm::mat4(1.f),
+				glm::vec3(.3f * size, .3f * size, half + 2.f)), glm::vec3(size));
+			auto eye = glm::vec3(glm::sin(frame * .02f) * half, 0.f,
+				half * 2.f + 10.f);
+			r.cameraU.data = Camera::_fromDir(eye, glm::vec3(0.f, 0.f, -1.f));
+
+			visible.clear();
+			bvh.cull(r.frustum(), visible);
+			auto& batch = r.batches[0];
+			batch.begin(1 + visible.size());
+			batch.submit(1, wall);
+			occlusion.begin(r.clipTransform());
+			occlusion.addOccluder(squareVertices.data(), 5 * sizeof(float),
+				squareIndices.data(), squareIndices.size(), wall * offsetTransform);
+			occlusion.rasterize();
+			for (uint32_t i : visible) {
+				if (!occlusion.visible(bvh.bounds[i])) continue;
+				auto& instance = field[i];
+				batch.submit(i % batch.ranges.size(), instance.transform,
+					instance.texIndex);
+			}
+		} },
+};
+
+static const Scene* findScene(const char* name) {
+	for (auto& scene : scenes)
+		if (!strcmp(scene.name, name)) return &scene;
+	return nullptr;
+}
+
+static double msSince(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+	const char* sceneName = "static";
+	const char* outPath = nullptr;
+	int frames = 1000, warmup = 50, width = 800, height = 600;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		#define arg(x) (!strcmp(argv[i], x))
+		if arg("--scene") sceneName = argv[i+1];
+		else if arg("--frames") frames = atoi(argv[i+1]);
+		else if arg("--warmup") warmup = atoi(argv[i+1]);
+		else if arg("--width") width = atoi(argv[i+1]);
+		else if arg("--height") height = atoi(argv[i+1]);
+		else if arg("--instances") instanceCount = atoi(argv[i+1]);
+		else if arg("--out") outPath = argv[i+1];
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+		#undef arg
+	}
+	const Scene* scene = findScene(sceneName);
+	if (!scene) {
+		fprintf(stderr, "Unknown scene %s\n", sceneName);
+		return -1;
+	}
+
+	auto context = HeadlessContext::create(width, height);
+	if (!context) return -1;
+
+	std::vector<double> cpuTimes, syncTimes;
+	long uniformUploads = 0, draws = 0, instances = 0;
+	GLState::Counters stateCalls{};
+	cpuTimes.reserve(frames);
+	syncTimes.reserve(frames);
+	{
+		auto r = Renderer(glm::vec2((float)width, (float)height));
+		// measure frames with the real textures, not the placeholders.
+		r.textures.finish();
+		scene->setup(r);
+		const Seconds delta = 1.f / 60.f;
+		const glm::vec4 clearColor(.3f, .3f, .3f, 1.f);
+		for (int i = 0; i < warmup; ++i) {
+			scene->update(r, i);
+			r.process(delta, clearColor);
+		}
+		glFinish();
+		auto countersBefore = glState.counters;
+		for (int i = 0; i < frames; ++i) {
+			scene->update(r, warmup + i);
+			auto start = Clock::now();
+			r.process(delta, clearColor);
+			auto submitted = Clock::now();
+			glFinish();
+			auto finished = Clock::now();
+			cpuTimes.push_back(msSince(start, submitted));
+			syncTimes.push_back(msSince(start, finished));
+			uniformUploads += r.uniformUploads;
+			draws += r.drawList.stats.draws;
+			instances += r.drawList.stats.instances;
+			for (auto& batch : r.batches) {
+				draws += batch.stats.draws;
+				instances += batch.stats.commands;
+			}
+		}
+		stateCalls.issued = glState.counters.issued - countersBefore.issued;
+		stateCalls.skipped = glState.counters.skipped - countersBefore.skipped;
+	}
+
+	FILE* file = outPath ? fopen(outPath, "w") : stdout;
+	if (!file) {
+		fprintf(stderr, "Failed to open %s\n", outPath);
+		return -1;
+	}
+	auto perFrame = [&](double total) { return frames > 0 ? total / frames : 0.; };
+	double syncTotal = 0.;
+	for (double t : syncTimes) syncTotal += t;
+	fprintf(file, "{\n\t\"scene\": \"%s\",\n\t\"renderer\": \"%s\",\n"
+		"\t\"width\": %d,\n\t\"height\": %d,\n\t\"frames\": %d,\n"
+		"\t\"warmup\": %d,\n",
+		scene->name, (const char*)glGetString(GL_RENDERER),
+		width, height, frames, warmup);
+	fprintf(file, "\t\"uniform_uploads_per_frame\": %.3f,\n"
+		"\t\"state_calls_per_frame\": {\"issued\": %.3f, \"skipped\": %.3f},\n"
+		"\t\"draws_per_frame\": %.3f,\n\t\"instances_per_frame\": %.3f,\n"
+		"\t\"instances_per_second\": %.1f,\n",
+		perFrame(uniformUploads), perFrame(stateCalls.issued),
+		perFrame(stateCalls.skipped), perFrame(draws), perFrame(instances),
+		syncTotal > 0. ? instances / (syncTotal / 1000.) : 0.);
+	fprintf(file, "\t\"unit\": \"ms\",\n\t\"frame_time\": {\n");
+	Stats::compute(cpuTimes).print(file, "cpu");
+	fprintf(file, ",\n");
+	Stats::compute(syncTimes).print(file, "gl_finish");
+	fprintf(file, "\n\t}\n}\n");
+	if (outPath) fclose(file);
+	context.destroy();
+	return 0;
+}
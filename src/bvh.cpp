@@ -0,0 +1,287 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+
+void Aabb::grow(glm::vec3 point) {
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void Aabb::grow(const Aabb& box) {
+	min = glm::min(min, box.min);
+	max = glm::max(max, box.max);
+}
+
+float Aabb::area() const {
+	auto e = max - min;
+	return e.x < 0.f ? 0.f : e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+bool Aabb::operator==(const Aabb& other) const {
+	return min == other.min && max == other.max;
+}
+
+Aabb Aabb::transformed(const glm::mat4& m) const {
+	// Arvo: each output axis picks the smaller and larger product per
+	// input axis, instead of transforming all eight corners.
+	Aabb out;
+	out.min = out.max = glm::vec3(m[3]);
+	for (int i = 0; i < 3; ++i) {
+		auto a = glm::vec3(m[i]) * min[i], b = glm::vec3(m[i]) * max[i];
+		out.min += glm::min(a, b);
+		out.max += glm::max(a, b);
+	}
+	return out;
+}
+
+static const uint32_t noParent = ~0u;
+static const int binCount = 12;
+
+Bvh Bvh::build(std::vector<Aabb> bounds, uint32_t maxLeafSize) {
+	Bvh out;
+	uint32_t n = bounds.size();
+	out.bounds = std::move(bounds);
+	out.leaves.resize(n);
+	out.objects.resize(n);
+	for (uint32_t i = 0; i < n; ++i) out.objects[i] = i;
+	if (n == 0) return out;
+	// a binary tree with at most one object per leaf has 2n-1 nodes, so
+	// references into nodes stay valid while splitting.
+	out.nodes.reserve(2 * n - 1);
+	out.parents.reserve(2 * n - 1);
+	out.nodes.push_back({glm::vec3(0.f), 0, glm::vec3(0.f), n});
+	out.parents.push_back(noParent);
+	out.centers.resize(n);
+	for (uint32_t i = 0; i < n; ++i) out.centers[i] = out.bounds[i].center();
+	out.split(0, std::max(maxLeafSize, 1u));
+	out.centers = {};
+	out.buildCost = out.cost();
+	return out;
+}
+
+void Bvh::split(uint32_t index, uint32_t maxLeafSize) {
+	Node& node = nodes[index];
+	uint32_t first = node.first, count = node.count;
+	Aabb box, centerBox;
+	for (uint32_t i = first; i < first + count; ++i) {
+		box.grow(bounds[objects[i]]);
+		centerBox.grow(centers[objects[i]]);
+	}
+	node.min = box.min;
+	node.max = box.max;
+
+	// cheapest split between bins along any axis, by SAH.
+	int bestAxis = -1, bestSplit = 0;
+	float bestCost = INFINITY;
+	auto extent = centerBox.max - centerBox.min;
+	for (int axis = 0; axis < 3 && count > 1; ++axis) {
+		if (extent[axis] <= 0.f) continue;
+		Aabb bins[binCount];
+		uint32_t binSizes[binCount] = {};
+		float scale = binCount / extent[axis];
+		for (uint32_t i = first; i < first + count; ++i) {
+			int bin = std::min(binCount - 1,
+				(int)((centers[objects[i]][axis] - centerBox.min[axis]) * scale));
+			bins[bin].grow(bounds[objects[i]]);
+			binSizes[bin]++;
+		}
+		// right to left sweep first, then test each boundary on the way
+		// back with the left side accumulated.
+		float rightCost[binCount];
+		Aabb right;
+		uint32_t rightSize = 0;
+		for (int i = binCount - 1; i > 0; --i) {
+			right.grow(bins[i]);
+			rightSize += binSizes[i];
+			rightCost[i] = rightSize ? right.area() * rightSize : INFINITY;
+		}
+		Aabb left;
+		uint32_t leftSize = 0;
+		for (int i = 0; i < binCount - 1; ++i) {
+			left.grow(bins[i]);
+			leftSize += binSizes[i];
+			if (!leftSize) continue;
+			float cost = left.area() * leftSize + rightCost[i + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	// traversing an inner node costs about as much as testing one object.
+	float leafCost = box.area() * count;
+	bool forced = count > maxLeafSize;
+	if (bestAxis < 0 && forced) {
+		// every center coincides, no plane separates them.
+		bestSplit = -1;
+	} else if (bestAxis < 0 || (!forced && box.area() + bestCost >= leafCost)) {
+		for (uint32_t i = first; i < first + count; ++i)
+			leaves[objects[i]] = index;
+		return;
+	}
+
+	uint32_t* begin = objects.data() + first;
+	uint32_t* middle;
+	if (bestSplit < 0) {
+		middle = begin + count / 2;
+	} else {
+		float scale = binCount / extent[bestAxis];
+		middle = std::partition(begin, begin + count, [&](uint32_t object) {
+			int bin = std::min(binCount - 1, (int)((centers[object][bestAxis]
+				- centerBox.min[bestAxis]) * scale));
+			return bin <= bestSplit;
+		});
+	}
+	uint32_t leftCount = middle - begin, child = nodes.size();
+	node.first = child;
+	node.count = 0;
+	nodes.push_back({glm::vec3(0.f), first, glm::vec3(0.f), leftCount});
+	nodes.push_back({glm::vec3(0.f), first + leftCount, glm::vec3(0.f),
+		count - leftCount});
+	parents.push_back(index);
+	parents.push_back(index);
+	split(child, maxLeafSize);
+	split(child + 1, maxLeafSize);
+}
+
+Aabb Bvh::fit(uint32_t index) const {
+	auto& node = nodes[index];
+	Aabb box;
+	if (node.leaf()) {
+		for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			box.grow(bounds[objects[i]]);
+	} else {
+		box.grow({nodes[node.first].min, nodes[node.first].max});
+		box.grow({nodes[node.first + 1].min, nodes[node.first + 1].max});
+	}
+	return box;
+}
+
+void Bvh::update(uint32_t object, const Aabb& box) {
+	bounds[object] = box;
+	for (uint32_t index = leaves[object]; index != noParent;
+		index = parents[index]) {
+		auto& node = nodes[index];
+		Aabb fitted = fit(index);
+		stats.nodesRefitted++;
+		if (fitted == Aabb{node.min, node.max}) break;
+		node.min = fitted.min;
+		node.max = fitted.max;
+	}
+}
+
+void Bvh::refit() {
+	for (size_t i = nodes.size(); i-- > 0;) {
+		Aabb fitted = fit(i);
+		nodes[i].min = fitted.min;
+		nodes[i].max = fitted.max;
+	}
+	stats.nodesRefitted += nodes.size();
+}
+
+float Bvh::cost() const {
+	if (nodes.empty()) return 0.f;
+	float sum = 0.f;
+	for (auto& node : nodes)
+		sum += Aabb{node.min, node.max}.area() * (node.leaf() ? node.count : 1);
+	float root = Aabb{nodes[0].min, nodes[0].max}.area();
+	return root > 0.f ? sum / root : 0.f;
+}
+
+enum Overlap { outside, intersecting, inside };
+
+// compares the corners nearest and furthest along each plane normal.
+static Overlap overlap(const Frustum& frustum, glm::vec3 min, glm::vec3 max) {
+	Overlap out = inside;
+	for (auto& p : frustum.planes) {
+		auto a = glm::vec3(p) * min, b = glm::vec3(p) * max;
+		auto lo = glm::min(a, b), hi = glm::max(a, b);
+		if (hi.x + hi.y + hi.z + p.w < 0.f) return outside;
+		if (lo.x + lo.y + lo.z + p.w < 0.f) out = intersecting;
+	}
+	return out;
+}
+
+size_t Bvh::cull(const Frustum& frustum, std::vector<uint32_t>& visible) {
+	size_t before = visible.size();
+	if (nodes.empty()) return 0;
+	// the low bit marks subtrees already known to be fully inside.
+	stack.clear();
+	stack.push_back(0);
+	while (!stack.empty()) {
+		uint32_t entry = stack.back();
+		stack.pop_back();
+		auto& node = nodes[entry >> 1];
+		Overlap o = entry & 1 ? inside : overlap(frustum, node.min, node.max);
+		stats.nodesVisited++;
+		if (o == outside) continue;
+		if (!node.leaf()) {
+			stack.push_back((node.first + 1) << 1 | (o == inside));
+			stack.push_back(node.first << 1 | (o == inside));
+		} else if (o == inside) {
+			visible.insert(visible.end(), objects.begin() + node.first,
+				objects.begin() + node.first + node.count);
+		} else {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				auto& b = bounds[objects[i]];
+				if (overlap(frustum, b.min, b.max) != outside)
+					visible.push_back(objects[i]);
+			}
+		}
+	}
+	return visible.size() - before;
+}
+
+// entry distance of the ray into the box, or INFINITY if it misses within
+// [0, maxT].
+static float slab(glm::vec3 origin, glm::vec3 invDir, glm::vec3 min,
+	glm::vec3 max, float maxT) {
+	auto t0 = (min - origin) * invDir, t1 = (max - origin) * invDir;
+	auto tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+	float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.f));
+	float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxT));
+	return enter <= exit ? enter : INFINITY;
+}
+
+bool Bvh::raycast(glm::vec3 origin, glm::vec3 dir, float maxT, Hit& hit) {
+	if (nodes.empty()) return false;
+	auto invDir = 1.f / dir;
+	float best = maxT;
+	bool found = false;
+	stack.clear();
+	stack.push_back(0);
+	while (!stack.empty()) {
+		auto& node = nodes[stack.back()];
+		stack.pop_back();
+		stats.nodesVisited++;
+		if (slab(origin, invDir, node.min, node.max, best) == INFINITY)
+			continue;
+		if (node.leaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				auto& b = bounds[objects[i]];
+				float t = slab(origin, invDir, b.min, b.max, best);
+				if (t == INFINITY) continue;
+				best = t;
+				hit = {objects[i], t};
+				found = true;
+			}
+			continue;
+		}
+		// nearer child on top of the stack, so it can shrink best before
+		// the other one is tested.
+		auto& a = nodes[node.first];
+		auto& b = nodes[node.first + 1];
+		float ta = slab(origin, invDir, a.min, a.max, best);
+		float tb = slab(origin, invDir, b.min, b.max, best);
+		uint32_t nearer = node.first, farther = node.first + 1;
+		if (tb < ta) {
+			std::swap(nearer, farther);
+			std::swap(ta, tb);
+		}
+		if (tb != INFINITY) stack.push_back(farther);
+		if (ta != INFINITY) stack.push_back(nearer);
+	}
+	return found;
+}
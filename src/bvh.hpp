@@ -0,0 +1,85 @@
+#pragma once
+
+#include "culling.hpp"
+#include "glm.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct Aabb {
+	glm::vec3 min = glm::vec3(INFINITY), max = glm::vec3(-INFINITY);
+
+	void grow(glm::vec3 point);
+	void grow(const Aabb& box);
+	glm::vec3 center() const { return (min + max) * .5f; }
+	// half the surface area, all SAH needs is the ratio between boxes.
+	float area() const;
+	bool operator==(const Aabb& other) const;
+	// bounds of this box after transform, still axis aligned.
+	Aabb transformed(const glm::mat4& transform) const;
+};
+
+// Bounding volume hierarchy over scene objects, one box per object.
+// Built top-down with binned SAH; moving objects are refitted in place,
+// which keeps the topology and lets quality decay, so callers rebuild
+// once cost() drifts too far from buildCost.
+//
+// Nodes live in one array with both children of a node stored next to
+// each other after their parent, so a reverse walk visits children first
+// and traversal reads each sibling pair from one contiguous 64 bytes.
+struct Bvh {
+	struct Node {
+		glm::vec3 min;
+		// first child for inner nodes, first entry in objects for leaves.
+		uint32_t first;
+		glm::vec3 max;
+		// objects in a leaf, 0 for inner nodes.
+		uint32_t count;
+		bool leaf() const { return count != 0; }
+	};
+	static_assert(sizeof(Node) == 32, "sibling pairs are 64 bytes");
+
+	struct Hit {
+		uint32_t object;
+		float t;
+	};
+
+	struct Stats {
+		int nodesVisited, nodesRefitted;
+	};
+
+	std::vector<Node> nodes;
+	// object indices in leaf order.
+	std::vector<uint32_t> objects;
+	std::vector<Aabb> bounds;
+	// parent of each node, and the leaf holding each object.
+	std::vector<uint32_t> parents, leaves;
+	float buildCost = 0.f;
+	Stats stats{};
+
+	static Bvh build(std::vector<Aabb> bounds, uint32_t maxLeafSize = 4);
+
+	// replaces one object's box and refits its ancestors, stopping as soon
+	// as a node comes out unchanged.
+	void update(uint32_t object, const Aabb& box);
+	// refits every node bottom up, cheaper than update() when most objects
+	// moved. boxes are read from bounds.
+	void refit();
+	// SAH cost of the current tree, relative to the root's area.
+	float cost() const;
+
+	// appends the objects whose box isn't fully outside the frustum, in
+	// tree order. subtrees fully inside are taken without further tests,
+	// so the result matches cullBoxes() over the same boxes.
+	size_t cull(const Frustum& frustum, std::vector<uint32_t>& visible);
+	// nearest object box hit by origin + t*dir with t in [0, maxT].
+	bool raycast(glm::vec3 origin, glm::vec3 dir, float maxT, Hit& hit);
+
+private:
+	std::vector<uint32_t> stack;
+	// box centers, only kept while building.
+	std::vector<glm::vec3> centers;
+	void split(uint32_t node, uint32_t maxLeafSize);
+	Aabb fit(uint32_t node) const;
+};
@@ -0,0 +1,156 @@
+#include "bvh.hpp"
+#include "culling.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Frustum culling micro-benchmark: runs every kernel over the same random
+// spheres and boxes and prints objects per nanosecond as JSON, then times
+// building, refitting, culling and ray casting a Bvh over the boxes.
+// Needs no GL.
+//
+// usage: cullbench [--objects n] [--reps n] [--seed n]
+
+using Clock = std::chrono::steady_clock;
+
+template <class Bounds, class Cull>
+static double objectsPerNs(const Bounds& bounds, int reps, Cull cull,
+	size_t* visibleCount) {
+	std::vector<uint32_t> visible(bounds.size());
+	*visibleCount = cull(visible.data());
+	auto start = Clock::now();
+	for (int i = 0; i < reps; ++i) *visibleCount = cull(visible.data());
+	double ns = std::chrono::duration<double, std::nano>(
+		Clock::now() - start).count();
+	return ns > 0. ? (double)bounds.size() * reps / ns : 0.;
+}
+
+static double msSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(
+		Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	int objects = 1 << 20, reps = 50;
+	unsigned seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		#define arg(x) (!strcmp(argv[i], x))
+		if arg("--objects") objects = atoi(argv[i+1]);
+		else if arg("--reps") reps = atoi(argv[i+1]);
+		else if arg("--seed") seed = atoi(argv[i+1]);
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+		#undef arg
+	}
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> position(-100.f, 100.f),
+		size(.1f, 2.f);
+	SphereBounds spheres;
+	BoxBounds boxes;
+	for (int i = 0; i < objects; ++i) {
+		glm::vec3 center(position(rng), position(rng), position(rng));
+		float r = size(rng);
+		spheres.push(center, r);
+		boxes.push(center - glm::vec3(r), center + glm::vec3(r));
+	}
+	auto view = glm::lookAt(glm::vec3(0.f, 0.f, 50.f), glm::vec3(0.f),
+		glm::vec3(0.f, 1.f, 0.f));
+	auto projection = glm::perspective(glm::radians(45.f), 4.f / 3.f,
+		.1f, 100.f);
+	auto frustum = Frustum::fromMatrix(projection * view);
+
+	printf("{\n\t\"objects\": %d,\n\t\"reps\": %d,\n\t\"best\": \"%s\",\n"
+		"\t\"unit\": \"objects/ns\",\n\t\"kernels\": [\n",
+		objects, reps, cullKernelName(cullBest));
+	size_t expectSpheres = 0, expectBoxes = 0;
+	bool mismatch = false;
+	for (int k = cullScalar; k <= bestCullKernel(); ++k) {
+		auto kernel = (CullKernel)k;
+		size_t visibleSpheres = 0, visibleBoxes = 0;
+		double sphereRate = objectsPerNs(spheres, reps, [&](uint32_t* out) {
+			return cullSpheres(frustum, spheres, out, kernel);
+		}, &visibleSpheres);
+		double boxRate = objectsPerNs(boxes, reps, [&](uint32_t* out) {
+			return cullBoxes(frustum, boxes, out, kernel);
+		}, &visibleBoxes);
+		if (k == cullScalar) {
+			expectSpheres = visibleSpheres;
+			expectBoxes = visibleBoxes;
+		}
+		mismatch |= visibleSpheres != expectSpheres
+			|| visibleBoxes != expectBoxes;
+		printf("%s\t\t{\"kernel\": \"%s\", \"spheres\": %.4f, "
+			"\"visible_spheres\": %zu, \"boxes\": %.4f, \"visible_boxes\": %zu}",
+			k == cullScalar ? "" : ",\n", cullKernelName(kernel),
+			sphereRate, visibleSpheres, boxRate, visibleBoxes);
+	}
+	printf("\n\t],\n");
+
+	// the bvh must find exactly the boxes the flat kernels keep.
+	std::vector<Aabb> aabbs(objects);
+	for (int i = 0; i < objects; ++i)
+		aabbs[i] = {{boxes.minX[i], boxes.minY[i], boxes.minZ[i]},
+			{boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]}};
+	auto start = Clock::now();
+	auto bvh = Bvh::build(aabbs);
+	double buildMs = msSince(start);
+
+	std::vector<uint32_t> visible;
+	visible.reserve(objects);
+	start = Clock::now();
+	for (int i = 0; i < reps; ++i) {
+		visible.clear();
+		bvh.cull(frustum, visible);
+	}
+	double cullNs = msSince(start) * 1e6 / reps;
+	mismatch |= visible.size() != expectBoxes;
+
+	// move a tenth of the objects, once through update() and once through
+	// a full refit().
+	std::uniform_int_distribution<int> pick(0, objects - 1);
+	std::uniform_real_distribution<float> nudge(-.5f, .5f);
+	int moved = objects / 10;
+	start = Clock::now();
+	for (int i = 0; i < moved; ++i) {
+		uint32_t object = pick(rng);
+		auto offset = glm::vec3(nudge(rng), nudge(rng), nudge(rng));
+		bvh.update(object, {aabbs[object].min + offset,
+			aabbs[object].max + offset});
+	}
+	double updateMs = msSince(start);
+	start = Clock::now();
+	bvh.refit();
+	double refitMs = msSince(start);
+
+	int rays = 100000, hits = 0;
+	bvh.stats.nodesVisited = 0;
+	start = Clock::now();
+	for (int i = 0; i < rays; ++i) {
+		glm::vec3 dir(nudge(rng), nudge(rng), nudge(rng));
+		Bvh::Hit hit;
+		hits += bvh.raycast(glm::vec3(0.f), dir, INFINITY, hit);
+	}
+	double rayNs = msSince(start) * 1e6 / rays;
+
+	printf("\t\"bvh\": {\"nodes\": %zu, \"build_ms\": %.3f, "
+		"\"build_cost\": %.2f, \"cull_objects_per_ns\": %.4f, "
+		"\"visible\": %zu,\n\t\t\"updated\": %d, \"update_ms\": %.3f, "
+		"\"refit_ms\": %.3f, \"refit_cost\": %.2f,\n\t\t\"rays\": %d, "
+		"\"ns_per_ray\": %.1f, \"nodes_per_ray\": %.1f, \"hits\": %d}\n}\n",
+		bvh.nodes.size(), buildMs, bvh.buildCost,
+		cullNs > 0. ? objects / cullNs : 0., visible.size(), moved, updateMs,
+		refitMs, bvh.cost(), rays, rayNs,
+		(double)bvh.stats.nodesVisited / rays, hits);
+	if (mismatch) {
+		fprintf(stderr, "Kernels disagree on the visible set\n");
+		return 1;
+	}
+	return 0;
+}
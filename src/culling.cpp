@@ -0,0 +1,238 @@
+#include "culling.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define CULL_X86
+	#include <immintrin.h>
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+	// Gribb/Hartmann: rows of m combined, glm stores columns.
+	auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+	Frustum out;
+	out.planes[0] = row(3) + row(0); // left
+	out.planes[1] = row(3) - row(0); // right
+	out.planes[2] = row(3) + row(1); // bottom
+	out.planes[3] = row(3) - row(1); // top
+	out.planes[4] = row(3) + row(2); // near
+	out.planes[5] = row(3) - row(2); // far
+	for (auto& plane : out.planes)
+		plane /= glm::length(glm::vec3(plane));
+	return out;
+}
+
+void SphereBounds::push(glm::vec3 center, float r) {
+	x.push_back(center.x);
+	y.push_back(center.y);
+	z.push_back(center.z);
+	radius.push_back(r);
+}
+
+void SphereBounds::clear() {
+	x.clear(); y.clear(); z.clear(); radius.clear();
+}
+
+void BoxBounds::push(glm::vec3 min, glm::vec3 max) {
+	minX.push_back(min.x); minY.push_back(min.y); minZ.push_back(min.z);
+	maxX.push_back(max.x); maxY.push_back(max.y); maxZ.push_back(max.z);
+}
+
+void BoxBounds::clear() {
+	minX.clear(); minY.clear(); minZ.clear();
+	maxX.clear(); maxY.clear(); maxZ.clear();
+}
+
+CullKernel bestCullKernel() {
+#ifdef CULL_X86
+	static const CullKernel best = __builtin_cpu_supports("avx") ? cullAVX
+		: __builtin_cpu_supports("sse2") ? cullSSE : cullScalar;
+	return best;
+#else
+	return cullScalar;
+#endif
+}
+
+const char* cullKernelName(CullKernel kernel) {
+	switch (kernel) {
+	case cullScalar: return "scalar";
+	case cullSSE: return "sse";
+	case cullAVX: return "avx";
+	default: return cullKernelName(bestCullKernel());
+	}
+}
+
+static CullKernel resolve(CullKernel kernel) {
+	CullKernel best = bestCullKernel();
+	return kernel > best ? best : kernel;
+}
+
+static size_t spheresScalar(const Frustum& f, const SphereBounds& b,
+	size_t begin, uint32_t* visible) {
+	size_t count = 0;
+	for (size_t i = begin; i < b.size(); ++i) {
+		bool inside = true;
+		for (auto& p : f.planes)
+			inside &= p.x * b.x[i] + p.y * b.y[i] + p.z * b.z[i] + p.w
+				>= -b.radius[i];
+		if (inside) visible[count++] = i;
+	}
+	return count;
+}
+
+// the plane's distance to the box corner furthest along its normal is the
+// sum of max(n*min, n*max) over the three axes.
+static size_t boxesScalar(const Frustum& f, const BoxBounds& b,
+	size_t begin, uint32_t* visible) {
+	size_t count = 0;
+	for (size_t i = begin; i < b.size(); ++i) {
+		bool inside = true;
+		for (auto& p : f.planes)
+			inside &= glm::max(p.x * b.minX[i], p.x * b.maxX[i])
+				+ glm::max(p.y * b.minY[i], p.y * b.maxY[i])
+				+ glm::max(p.z * b.minZ[i], p.z * b.maxZ[i]) + p.w >= 0.f;
+		if (inside) visible[count++] = i;
+	}
+	return count;
+}
+
+// appends base + the index of every set bit in mask.
+static inline size_t emit(unsigned mask, size_t base, uint32_t* visible) {
+	size_t count = 0;
+	while (mask) {
+		visible[count++] = base + __builtin_ctz(mask);
+		mask &= mask - 1;
+	}
+	return count;
+}
+
+#ifdef CULL_X86
+__attribute__((target("sse2")))
+static size_t spheresSSE(const Frustum& f, const SphereBounds& b,
+	uint32_t* visible) {
+	__m128 nx[6], ny[6], nz[6], nw[6];
+	for (int p = 0; p < 6; ++p) {
+		nx[p] = _mm_set1_ps(f.planes[p].x);
+		ny[p] = _mm_set1_ps(f.planes[p].y);
+		nz[p] = _mm_set1_ps(f.planes[p].z);
+		nw[p] = _mm_set1_ps(f.planes[p].w);
+	}
+	size_t n = b.size(), i = 0, count = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 x = _mm_loadu_ps(&b.x[i]), y = _mm_loadu_ps(&b.y[i]),
+			z = _mm_loadu_ps(&b.z[i]),
+			negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&b.radius[i]));
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; ++p) {
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], x),
+				_mm_mul_ps(ny[p], y)), _mm_add_ps(_mm_mul_ps(nz[p], z), nw[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+		}
+		count += emit(_mm_movemask_ps(inside), i, visible + count);
+	}
+	return count + spheresScalar(f, b, i, visible + count);
+}
+
+__attribute__((target("sse2")))
+static size_t boxesSSE(const Frustum& f, const BoxBounds& b,
+	uint32_t* visible) {
+	size_t n = b.size(), i = 0, count = 0;
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= n; i += 4) {
+		__m128 minX = _mm_loadu_ps(&b.minX[i]), maxX = _mm_loadu_ps(&b.maxX[i]),
+			minY = _mm_loadu_ps(&b.minY[i]), maxY = _mm_loadu_ps(&b.maxY[i]),
+			minZ = _mm_loadu_ps(&b.minZ[i]), maxZ = _mm_loadu_ps(&b.maxZ[i]);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (auto& p : f.planes) {
+			__m128 nx = _mm_set1_ps(p.x), ny = _mm_set1_ps(p.y),
+				nz = _mm_set1_ps(p.z);
+			__m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_max_ps(_mm_mul_ps(nx, minX), _mm_mul_ps(nx, maxX)),
+					_mm_max_ps(_mm_mul_ps(ny, minY), _mm_mul_ps(ny, maxY))),
+				_mm_add_ps(_mm_max_ps(_mm_mul_ps(nz, minZ), _mm_mul_ps(nz, maxZ)),
+					_mm_set1_ps(p.w)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+		}
+		count += emit(_mm_movemask_ps(inside), i, visible + count);
+	}
+	return count + boxesScalar(f, b, i, visible + count);
+}
+
+__attribute__((target("avx")))
+static size_t spheresAVX(const Frustum& f, const SphereBounds& b,
+	uint32_t* visible) {
+	__m256 nx[6], ny[6], nz[6], nw[6];
+	for (int p = 0; p < 6; ++p) {
+		nx[p] = _mm256_set1_ps(f.planes[p].x);
+		ny[p] = _mm256_set1_ps(f.planes[p].y);
+		nz[p] = _mm256_set1_ps(f.planes[p].z);
+		nw[p] = _mm256_set1_ps(f.planes[p].w);
+	}
+	size_t n = b.size(), i = 0, count = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 x = _mm256_loadu_ps(&b.x[i]), y = _mm256_loadu_ps(&b.y[i]),
+			z = _mm256_loadu_ps(&b.z[i]),
+			negR = _mm256_sub_ps(_mm256_setzero_ps(),
+				_mm256_loadu_ps(&b.radius[i]));
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; ++p) {
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], x),
+				_mm256_mul_ps(ny[p], y)),
+				_mm256_add_ps(_mm256_mul_ps(nz[p], z), nw[p]));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+		}
+		count += emit(_mm256_movemask_ps(inside), i, visible + count);
+	}
+	return count + spheresScalar(f, b, i, visible + count);
+}
+
+__attribute__((target("avx")))
+static size_t boxesAVX(const Frustum& f, const BoxBounds& b,
+	uint32_t* visible) {
+	size_t n = b.size(), i = 0, count = 0;
+	const __m256 zero = _mm256_setzero_ps();
+	for (; i + 8 <= n; i += 8) {
+		__m256 minX = _mm256_loadu_ps(&b.minX[i]),
+			maxX = _mm256_loadu_ps(&b.maxX[i]),
+			minY = _mm256_loadu_ps(&b.minY[i]),
+			maxY = _mm256_loadu_ps(&b.maxY[i]),
+			minZ = _mm256_loadu_ps(&b.minZ[i]),
+			maxZ = _mm256_loadu_ps(&b.maxZ[i]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (auto& p : f.planes) {
+			__m256 nx = _mm256_set1_ps(p.x), ny = _mm256_set1_ps(p.y),
+				nz = _mm256_set1_ps(p.z);
+			__m256 d = _mm256_add_ps(
+				_mm256_add_ps(
+					_mm256_max_ps(_mm256_mul_ps(nx, minX), _mm256_mul_ps(nx, maxX)),
+					_mm256_max_ps(_mm256_mul_ps(ny, minY), _mm256_mul_ps(ny, maxY))),
+				_mm256_add_ps(
+					_mm256_max_ps(_mm256_mul_ps(nz, minZ), _mm256_mul_ps(nz, maxZ)),
+					_mm256_set1_ps(p.w)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, zero, _CMP_GE_OQ));
+		}
+		count += emit(_mm256_movemask_ps(inside), i, visible + count);
+	}
+	return count + boxesScalar(f, b, i, visible + count);
+}
+#endif
+
+size_t cullSpheres(const Frustum& frustum, const SphereBounds& bounds,
+	uint32_t* visible, CullKernel kernel) {
+	switch (resolve(kernel)) {
+#ifdef CULL_X86
+	case cullAVX: return spheresAVX(frustum, bounds, visible);
+	case cullSSE: return spheresSSE(frustum, bounds, visible);
+#endif
+	default: return spheresScalar(frustum, bounds, 0, visible);
+	}
+}
+
+size_t cullBoxes(const Frustum& frustum, const BoxBounds& bounds,
+	uint32_t* visible, CullKernel kernel) {
+	switch (resolve(kernel)) {
+#ifdef CULL_X86
+	case cullAVX: return boxesAVX(frustum, bounds, visible);
+	case cullSSE: return boxesSSE(frustum, bounds, visible);
+#endif
+	default: return boxesScalar(frustum, bounds, 0, visible);
+	}
+}
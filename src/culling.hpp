@@ -0,0 +1,55 @@
+#pragma once
+
+#include "glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Planes of a view frustum, normalized and pointing inwards: a point p is
+// inside plane i when dot(planes[i].xyz, p) + planes[i].w >= 0.
+struct Frustum {
+	glm::vec4 planes[6];
+	// extracts the planes from a clip-space transform, e.g. viewProjection.
+	static Frustum fromMatrix(const glm::mat4& m);
+};
+
+// bounding spheres stored as structure of arrays, so the SIMD kernels load
+// one component of 4 or 8 objects at once.
+struct SphereBounds {
+	std::vector<float> x, y, z, radius;
+	void push(glm::vec3 center, float r);
+	void clear();
+	size_t size() const { return x.size(); }
+};
+
+// axis aligned boxes, structure of arrays like SphereBounds.
+struct BoxBounds {
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+	void push(glm::vec3 min, glm::vec3 max);
+	void clear();
+	size_t size() const { return minX.size(); }
+};
+
+enum CullKernel {
+	cullScalar,
+	// 4 objects per iteration.
+	cullSSE,
+	// 8 objects per iteration.
+	cullAVX,
+	// widest kernel the cpu supports.
+	cullBest,
+};
+
+// the kernel cullBest resolves to on this cpu.
+CullKernel bestCullKernel();
+const char* cullKernelName(CullKernel kernel);
+
+// write the indices of the objects that aren't fully outside some plane to
+// visible, which must hold bounds.size() entries, in ascending order.
+// returns how many were written. kernels the cpu lacks fall back to the
+// next narrower one.
+size_t cullSpheres(const Frustum& frustum, const SphereBounds& bounds,
+	uint32_t* visible, CullKernel kernel = cullBest);
+size_t cullBoxes(const Frustum& frustum, const BoxBounds& bounds,
+	uint32_t* visible, CullKernel kernel = cullBest);
@@ -0,0 +1,135 @@
+#include "drawlist.hpp"
+#include "renderer.hpp"
+
+#include <cstring>
+
+Material Material::create(const ShaderProgram& program,
+	std::vector<Texture>&& textures, RenderPass pass) {
+	static uint16_t nextId = 0;
+	Material out;
+	out.program = program.obj;
+	out.modelId = program.getUniformId("model");
+	out.textures = std::move(textures);
+	out.pass = pass;
+	out.id = nextId++;
+	return out;
+}
+
+void Material::bind() const {
+	glState.useProgram(program);
+	for (auto texture : textures) texture.bind();
+}
+
+DrawList::Key DrawList::makeKey(RenderPass pass, GLuint program,
+	uint16_t material, GLuint VAO, float depth) {
+	const Key depthMax = (1 << 20) - 1;
+	Key d = (Key)(glm::clamp(depth, 0.f, 1.f) * depthMax);
+	Key p = program & 0xFFF, v = VAO & 0xFFF, m = material;
+	if (pass == transparentPass)
+		return (Key)pass << 60 | (depthMax - d) << 40 | p << 28 | m << 12 | v;
+	return (Key)pass << 60 | p << 48 | m << 32 | v << 20 | d;
+}
+
+void DrawList::begin(const glm::mat4& view, float farPlane) {
+	this->view = view;
+	this->farPlane = farPlane;
+	items.clear();
+	keys.clear();
+	order.clear();
+	sorted = false;
+}
+
+void DrawList::submit(const Mesh& mesh, const Material& material,
+	const glm::mat4& transform, const InstanceBuffer* instances) {
+	float depth = -(view * transform[3]).z / farPlane;
+	keys.push_back(makeKey(material.pass, material.program, material.id,
+		instances ? instances->VAO : mesh.VAO, depth));
+	items.push_back({&mesh, &material, transform * mesh.decode, instances});
+	sorted = false;
+}
+
+// LSD radix sort, one byte per pass. passes where every key has the same
+// byte are skipped, which is most of them when few states are in use.
+void DrawList::sort() {
+	const size_t n = keys.size();
+	order.resize(n);
+	for (size_t i = 0; i < n; ++i) order[i] = i;
+	keyScratch.resize(n);
+	orderScratch.resize(n);
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t count[256] = {};
+		for (Key key : keys) ++count[(key >> shift) & 0xFF];
+		if (n == 0 || count[(keys[0] >> shift) & 0xFF] == n) continue;
+		size_t offset = 0;
+		for (auto& c : count) {
+			size_t next = offset + c;
+			c = offset;
+			offset = next;
+		}
+		for (size_t i = 0; i < n; ++i) {
+			size_t dst = count[(keys[i] >> shift) & 0xFF]++;
+			keyScratch[dst] = keys[i];
+			orderScratch[dst] = order[i];
+		}
+		keys.swap(keyScratch);
+		order.swap(orderScratch);
+	}
+	sorted = true;
+}
+
+bool DrawList::transformChanged(GLuint program, const glm::mat4& transform) {
+	for (auto& [uploadedProgram, uploaded] : uploadedTransforms) {
+		if (uploadedProgram != program) continue;
+		if (!memcmp(&uploaded, &transform, sizeof(glm::mat4))) return false;
+		uploaded = transform;
+		return true;
+	}
+	uploadedTransforms.push_back({program, transform});
+	return true;
+}
+
+int DrawList::execute() {
+	if (!sorted) sort();
+	stats = {};
+	const Material* material = nullptr;
+	int pass = -1;
+	for (uint32_t i : order) {
+		const DrawItem& item = items[i];
+		if (item.material->pass != pass) {
+			pass = item.material->pass;
+			bool transparent = pass == transparentPass;
+			glState.setBlend(transparent);
+			glState.setDepthMask(!transparent);
+			if (transparent)
+				glState.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		}
+		if (item.material != material) {
+			material = item.material;
+			material->bind();
+			++stats.materialBinds;
+		}
+		if (material->modelId >= 0
+			&& transformChanged(material->program, item.transform)) {
+			setUniform(material->modelId, item.transform);
+			++stats.transformUploads;
+		}
+		const Mesh& mesh = *item.mesh;
+		auto indices = (GLvoid*)mesh.allocation.indexOffset;
+		if (item.instances) {
+			glState.bindVertexArray(item.instances->VAO);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.indexCount,
+				mesh.indexType, indices, item.instances->count,
+				mesh.allocation.baseVertex);
+			stats.instances += item.instances->count;
+		} else {
+			glState.bindVertexArray(mesh.VAO);
+			glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount,
+				mesh.indexType, indices, mesh.allocation.baseVertex);
+			++stats.instances;
+		}
+		++stats.draws;
+	}
+	// glClear ignores a disabled depth mask.
+	glState.setDepthMask(true);
+	return stats.draws;
+}
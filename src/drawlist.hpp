@@ -0,0 +1,82 @@
+#pragma once
+
+#include "glm.hpp"
+#include "glstate.hpp"
+#include "instancing.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct Mesh;
+
+enum RenderPass : uint8_t {
+	opaquePass,
+	transparentPass,
+};
+
+// program and textures shared by every draw that uses it. textures are bound
+// to their own units, the program's samplers have to be set up beforehand.
+struct Material {
+	GLuint program;
+	// location of the per-draw "model" uniform.
+	GLint modelId;
+	std::vector<Texture> textures;
+	RenderPass pass;
+	uint16_t id;
+	static Material create(const ShaderProgram& program,
+		std::vector<Texture>&& textures, RenderPass pass = opaquePass);
+	void bind() const;
+};
+
+struct DrawItem {
+	const Mesh* mesh;
+	const Material* material;
+	glm::mat4 transform;
+	// drawn with glDrawElementsInstanced when set.
+	const InstanceBuffer* instances;
+};
+
+// Collects the frame's draws, orders them by a 64-bit key so state changes
+// are grouped, and issues them. Opaque keys are
+//	pass:4 | program:12 | material:16 | VAO:12 | depth:20
+// drawing front to back within a state group, transparent keys are
+//	pass:4 | ~depth:20 | program:12 | material:16 | VAO:12
+// drawing back to front. Ids wider than their field are truncated, which
+// only costs sort quality.
+struct DrawList {
+	using Key = uint64_t;
+	struct Stats {
+		int draws, instances, materialBinds, transformUploads;
+	} stats{};
+	std::vector<DrawItem> items;
+	std::vector<Key> keys;
+	std::vector<uint32_t> order;
+
+	// clears the list. depth is measured in view space along -z and
+	// quantized over [0, farPlane].
+	void begin(const glm::mat4& view, float farPlane);
+	void submit(const Mesh& mesh, const Material& material,
+		const glm::mat4& transform, const InstanceBuffer* instances = nullptr);
+	// radix sorts keys, order then holds item indices in draw order.
+	void sort();
+	// sorts if needed and issues every draw, returns the draw count.
+	int execute();
+	static Key makeKey(RenderPass pass, GLuint program, uint16_t material,
+		GLuint VAO, float depth);
+
+private:
+	glm::mat4 view{1.f};
+	float farPlane = 1.f;
+	bool sorted = false;
+	std::vector<Key> keyScratch;
+	std::vector<uint32_t> orderScratch;
+	// last transform sent to each program's model uniform. uniforms are
+	// program state, so this stays valid between frames.
+	std::vector<std::pair<GLuint, glm::mat4>> uploadedTransforms;
+	bool transformChanged(GLuint program, const glm::mat4& transform);
+};
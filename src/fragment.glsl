@@ -1,18 +1,22 @@
 #version 330 core
 
 in vec2 texCoord;
+flat in float layer;
 
 out vec4 FragColor;
 
-uniform sampler2D tex;
-uniform sampler2D tex2;
+uniform sampler2DArray layers;
 uniform float redValue;
-uniform vec2 resolution;
 
-void main() {
-	vec4 texColor1 = texture(tex, texCoord);
-	vec4 texColor2 = texture(tex2, texCoord);
-	vec2 uv = gl_FragCoord.xy / resolution;
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec2 resolution;
+	float time;
+};
 
-	FragColor = mix(texColor1, texColor2, uv.x);
+void main() {
+	FragColor = texture(layers, vec3(texCoord, layer));
 }
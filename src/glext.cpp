@@ -0,0 +1,55 @@
+#include "glext.hpp"
+#include "logging.h"
+
+#include <cstring>
+
+int GLEXT_base_instance = 0;
+int GLEXT_multi_draw_indirect = 0;
+int GLEXT_buffer_storage = 0;
+int GLEXT_texture_storage = 0;
+
+PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC
+	glext_glDrawElementsInstancedBaseVertexBaseInstance = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect = nullptr;
+PFNGLBUFFERSTORAGEPROC glext_glBufferStorage = nullptr;
+PFNGLTEXSTORAGE2DPROC glext_glTexStorage2D = nullptr;
+PFNGLTEXSTORAGE3DPROC glext_glTexStorage3D = nullptr;
+
+static bool versionAtLeast(int major, int minor) {
+	return GLVersion.major > major
+		|| (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool hasGLExtension(const char* name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		auto extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension && !strcmp(extension, name)) return true;
+	}
+	return false;
+}
+
+void loadGLExtensions(GLADloadproc load) {
+	#define loadext(x) glext_##x = (decltype(glext_##x))load(#x)
+	loadext(glDrawElementsInstancedBaseVertexBaseInstance);
+	loadext(glMultiDrawElementsIndirect);
+	loadext(glBufferStorage);
+	loadext(glTexStorage2D);
+	loadext(glTexStorage3D);
+	#undef loadext
+
+	GLEXT_base_instance = glext_glDrawElementsInstancedBaseVertexBaseInstance
+		&& (versionAtLeast(4, 2) || hasGLExtension("GL_ARB_base_instance"));
+	GLEXT_multi_draw_indirect = glext_glMultiDrawElementsIndirect
+		&& (versionAtLeast(4, 3)
+			|| hasGLExtension("GL_ARB_multi_draw_indirect"));
+	GLEXT_buffer_storage = glext_glBufferStorage
+		&& (versionAtLeast(4, 4) || hasGLExtension("GL_ARB_buffer_storage"));
+	GLEXT_texture_storage = glext_glTexStorage2D && glext_glTexStorage3D
+		&& (versionAtLeast(4, 2) || hasGLExtension("GL_ARB_texture_storage"));
+	LOG("loadGLExtensions: base_instance %d, multi_draw_indirect %d, "
+		"buffer_storage %d, texture_storage %d\n", GLEXT_base_instance,
+		GLEXT_multi_draw_indirect, GLEXT_buffer_storage,
+		GLEXT_texture_storage);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Entry points newer than the GL 4.0 core profile glad was generated for.
+// loadGLExtensions() has to run right after gladLoadGLLoader. Check the
+// GLEXT_ flags before calling anything here, drivers may hand out pointers
+// for functions they don't support.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+#ifndef GL_TEXTURE_IMMUTABLE_FORMAT
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#endif
+
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)
+	(GLenum mode, GLsizei count, GLenum type, const void* indices,
+	GLsizei instancecount, GLint basevertex, GLuint baseinstance);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode,
+	GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target,
+	GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels,
+	GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXSTORAGE3DPROC)(GLenum target, GLsizei levels,
+	GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+
+// GL 4.2 or ARB_base_instance.
+extern int GLEXT_base_instance;
+// GL 4.3 or ARB_multi_draw_indirect.
+extern int GLEXT_multi_draw_indirect;
+// GL 4.4 or ARB_buffer_storage.
+extern int GLEXT_buffer_storage;
+// GL 4.2 or ARB_texture_storage.
+extern int GLEXT_texture_storage;
+
+extern PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC
+	glext_glDrawElementsInstancedBaseVertexBaseInstance;
+#define glDrawElementsInstancedBaseVertexBaseInstance \
+	glext_glDrawElementsInstancedBaseVertexBaseInstance
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_glMultiDrawElementsIndirect
+extern PFNGLBUFFERSTORAGEPROC glext_glBufferStorage;
+#define glBufferStorage glext_glBufferStorage
+extern PFNGLTEXSTORAGE2DPROC glext_glTexStorage2D;
+#define glTexStorage2D glext_glTexStorage2D
+extern PFNGLTEXSTORAGE3DPROC glext_glTexStorage3D;
+#define glTexStorage3D glext_glTexStorage3D
+
+bool hasGLExtension(const char* name);
+void loadGLExtensions(GLADloadproc load);
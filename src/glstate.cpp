@@ -0,0 +1,172 @@
+#include "glstate.hpp"
+
+GLState glState;
+
+void GLState::invalidate() {
+	program = VAO = unknown;
+	arrayBuffer = elementBuffer = uniformBuffer = indirectBuffer = unknown;
+	pixelUnpackBuffer = unknown;
+	activeUnit = unknown;
+	for (auto& unit : textures)
+		unit[0] = unit[1] = unknown;
+	depthTest = depthMask = blend = -1;
+	depthFunc = blendSrc = blendDst = unknown;
+	viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+}
+
+bool GLState::changed(GLuint& cached, GLuint value) {
+	if (cached == value) {
+		++counters.skipped;
+		return false;
+	}
+	cached = value;
+	++counters.issued;
+	return true;
+}
+
+bool GLState::changed(GLint& cached, GLint value) {
+	if (cached == value) {
+		++counters.skipped;
+		return false;
+	}
+	cached = value;
+	++counters.issued;
+	return true;
+}
+
+void GLState::useProgram(GLuint program) {
+	if (changed(this->program, program)) glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint VAO) {
+	if (!changed(this->VAO, VAO)) return;
+	glBindVertexArray(VAO);
+	elementBuffer = unknown;
+}
+
+GLuint* GLState::bufferSlot(GLenum target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER: return &arrayBuffer;
+	case GL_ELEMENT_ARRAY_BUFFER: return &elementBuffer;
+	case GL_UNIFORM_BUFFER: return &uniformBuffer;
+	case GL_DRAW_INDIRECT_BUFFER: return &indirectBuffer;
+	case GL_PIXEL_UNPACK_BUFFER: return &pixelUnpackBuffer;
+	default: return nullptr;
+	}
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+	GLuint* slot = bufferSlot(target);
+	if (!slot) {
+		++counters.issued;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	if (changed(*slot, buffer)) glBindBuffer(target, buffer);
+}
+
+// indexed bindings aren't cached, but binding one also sets the generic one.
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+	++counters.issued;
+	glBindBufferBase(target, index, buffer);
+	if (GLuint* slot = bufferSlot(target)) *slot = buffer;
+}
+
+int GLState::targetSlot(GLenum target) {
+	switch (target) {
+	case GL_TEXTURE_2D: return 0;
+	case GL_TEXTURE_2D_ARRAY: return 1;
+	default: return -1;
+	}
+}
+
+void GLState::activeTexture(GLenum unit) {
+	if (changed(activeUnit, unit)) glActiveTexture(unit);
+}
+
+void GLState::bindTexture(GLenum unit, GLenum target, GLuint texture) {
+	int index = unit - GL_TEXTURE0, slot = targetSlot(target);
+	// even when texture is already bound: glTex* calls after a bind act on
+	// the active unit's texture.
+	activeTexture(unit);
+	if (index < 0 || index >= maxUnits || slot < 0) {
+		++counters.issued;
+		glBindTexture(target, texture);
+		return;
+	}
+	if (textures[index][slot] == texture) {
+		++counters.skipped;
+		return;
+	}
+	textures[index][slot] = texture;
+	++counters.issued;
+	glBindTexture(target, texture);
+}
+
+void GLState::setDepthTest(bool enabled) {
+	if (!changed(depthTest, enabled)) return;
+	if (enabled) glEnable(GL_DEPTH_TEST);
+	else glDisable(GL_DEPTH_TEST);
+}
+
+void GLState::setDepthMask(bool enabled) {
+	if (changed(depthMask, enabled)) glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::setDepthFunc(GLenum func) {
+	if (changed(depthFunc, func)) glDepthFunc(func);
+}
+
+void GLState::setBlend(bool enabled) {
+	if (!changed(blend, enabled)) return;
+	if (enabled) glEnable(GL_BLEND);
+	else glDisable(GL_BLEND);
+}
+
+void GLState::setBlendFunc(GLenum src, GLenum dst) {
+	if (blendSrc == src && blendDst == dst) {
+		++counters.skipped;
+		return;
+	}
+	blendSrc = src;
+	blendDst = dst;
+	++counters.issued;
+	glBlendFunc(src, dst);
+}
+
+void GLState::setViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	if (viewport[0] == x && viewport[1] == y
+		&& viewport[2] == width && viewport[3] == height) {
+		++counters.skipped;
+		return;
+	}
+	viewport[0] = x;
+	viewport[1] = y;
+	viewport[2] = width;
+	viewport[3] = height;
+	++counters.issued;
+	glViewport(x, y, width, height);
+}
+
+void GLState::forgetProgram(GLuint program) {
+	if (this->program == program) this->program = unknown;
+}
+
+void GLState::forgetVertexArray(GLuint VAO) {
+	if (this->VAO == VAO) {
+		this->VAO = unknown;
+		elementBuffer = unknown;
+	}
+}
+
+void GLState::forgetBuffer(GLuint buffer) {
+	for (GLuint* slot : {&arrayBuffer, &elementBuffer, &uniformBuffer,
+		&indirectBuffer, &pixelUnpackBuffer})
+		if (*slot == buffer) *slot = unknown;
+}
+
+void GLState::forgetTexture(GLuint texture) {
+	for (auto& unit : textures)
+	for (auto& bound : unit)
+		if (bound == texture) bound = unknown;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <initializer_list>
+
+// Shadow copy of the GL state we touch every frame. Calls that would set a
+// value that's already current are skipped and counted. Every bind in the
+// renderer should go through glState, anything set behind its back (or
+// deleted without forget*) leaves the cache stale; invalidate() resets it
+// to unknown, so the next call of each kind is always issued.
+struct GLState {
+	static constexpr GLuint unknown = ~0u;
+	static constexpr int maxUnits = 32;
+
+	struct Counters {
+		unsigned long issued = 0, skipped = 0;
+	} counters;
+
+	GLuint program = unknown;
+	GLuint VAO = unknown;
+	// ELEMENT_ARRAY_BUFFER is part of the VAO, so it becomes unknown
+	// whenever the VAO changes.
+	GLuint arrayBuffer = unknown, elementBuffer = unknown,
+		uniformBuffer = unknown, indirectBuffer = unknown,
+		pixelUnpackBuffer = unknown;
+	GLenum activeUnit = unknown;
+	// one slot per target kind on each unit, see targetSlot().
+	GLuint textures[maxUnits][2];
+	GLint depthTest = -1, depthMask = -1, blend = -1;
+	GLenum depthFunc = unknown, blendSrc = unknown, blendDst = unknown;
+	GLint viewport[4];
+
+	GLState() { invalidate(); }
+	void invalidate();
+
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint VAO);
+	void bindBuffer(GLenum target, GLuint buffer);
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	// unit is GL_TEXTURE0 + n, like glActiveTexture. Leaves unit active, so
+	// it selects texture for the glTex* calls that follow.
+	void bindTexture(GLenum unit, GLenum target, GLuint texture);
+	void setDepthTest(bool enabled);
+	void setDepthMask(bool enabled);
+	void setDepthFunc(GLenum func);
+	void setBlend(bool enabled);
+	void setBlendFunc(GLenum src, GLenum dst);
+	void setViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+	// call after deleting GL objects, their names may be reused.
+	void forgetProgram(GLuint program);
+	void forgetVertexArray(GLuint VAO);
+	void forgetBuffer(GLuint buffer);
+	void forgetTexture(GLuint texture);
+
+private:
+	bool changed(GLuint& cached, GLuint value);
+	bool changed(GLint& cached, GLint value);
+	void activeTexture(GLenum unit);
+	GLuint* bufferSlot(GLenum target);
+	static int targetSlot(GLenum target);
+};
+
+extern GLState glState;
@@ -0,0 +1,144 @@
+#include "headless.hpp"
+#include "arena.hpp"
+#include "glext.hpp"
+
+#include <EGL/eglext.h>
+
+#include <cstdio>
+#include <iostream>
+
+static EGLDisplay getDisplay() {
+	auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+		eglGetProcAddress("eglGetPlatformDisplayEXT");
+	EGLDisplay display = EGL_NO_DISPLAY;
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+			EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	return display;
+}
+
+HeadlessContext HeadlessContext::create(int width, int height) {
+	HeadlessContext out;
+	out.width = width;
+	out.height = height;
+
+	out.display = getDisplay();
+	EGLint major=0, minor=0;
+	if (out.display == EGL_NO_DISPLAY
+		|| !eglInitialize(out.display, &major, &minor)) {
+		std::cout << "Failed to initialize EGL\n";
+		return out;
+	}
+	LOG("HeadlessContext::create: EGL %d.%d\n", major, minor);
+	eglBindAPI(EGL_OPENGL_API);
+
+	// same version and profile GLFWwindow_create asks for.
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	// surfaceless contexts don't need a config, fall back to picking one
+	// for drivers without EGL_KHR_no_config_context.
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	out.context = eglCreateContext(out.display, config, EGL_NO_CONTEXT,
+		contextAttribs);
+	if (out.context == EGL_NO_CONTEXT) {
+		const EGLint configAttribs[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_NONE
+		};
+		EGLint count = 0;
+		if (eglChooseConfig(out.display, configAttribs, &config, 1, &count)
+			&& count > 0)
+			out.context = eglCreateContext(out.display, config,
+				EGL_NO_CONTEXT, contextAttribs);
+	}
+	if (out.context == EGL_NO_CONTEXT) {
+		std::cout << "Failed to create EGL context\n";
+		out.destroy();
+		return out;
+	}
+	if (!eglMakeCurrent(out.display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+		out.context)) {
+		std::cout << "Failed to make EGL context current\n";
+		out.destroy();
+		return out;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		std::cout << "Failed to initialize GLAD\n";
+		out.destroy();
+		return out;
+	}
+	loadGLExtensions((GLADloadproc)eglGetProcAddress);
+	LOG("HeadlessContext::create: %s\n", glGetString(GL_RENDERER));
+
+	glGenRenderbuffers(1, &out.colorRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, out.colorRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &out.depthRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, out.depthRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &out.FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, out.FBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+		GL_RENDERBUFFER, out.colorRBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+		GL_RENDERBUFFER, out.depthRBO);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Headless framebuffer is incomplete\n";
+		out.destroy();
+		return out;
+	}
+
+	glState.setViewport(0,0, width, height);
+	return out;
+}
+
+std::vector<unsigned char> HeadlessContext::readPixels() {
+	std::vector<unsigned char> out(width * height * 4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0,0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, out.data());
+	return out;
+}
+
+bool HeadlessContext::writePPM(const char* path) {
+	auto pixels = readPixels();
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	for (int y = height - 1; y >= 0; --y)
+	for (int x = 0; x < width; ++x)
+		fwrite(&pixels[(y * width + x) * 4], 1, 3, file);
+	fclose(file);
+	return true;
+}
+
+void HeadlessContext::destroy() {
+	if (context != EGL_NO_CONTEXT) {
+		// GL objects only exist once glad has been loaded.
+		if (colorRBO) {
+			MeshArena::destroyAll();
+			glDeleteFramebuffers(1, &FBO);
+			glDeleteRenderbuffers(1, &colorRBO);
+			glDeleteRenderbuffers(1, &depthRBO);
+		}
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+	}
+	if (display != EGL_NO_DISPLAY) eglTerminate(display);
+	context = EGL_NO_CONTEXT;
+	display = EGL_NO_DISPLAY;
+	glState.invalidate();
+	FBO = colorRBO = depthRBO = 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "logging.h"
+#include "glstate.hpp"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+
+#include <vector>
+
+// Offscreen GL context for machines without a display. Uses EGL on the
+// surfaceless Mesa platform (llvmpipe works), and renders into an FBO of the
+// requested size instead of a window's default framebuffer. Build with
+// -DHEADLESS so the renderer doesn't depend on GLFW.
+struct HeadlessContext {
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	GLuint FBO=0, colorRBO=0, depthRBO=0;
+	int width=0, height=0;
+	static HeadlessContext create(int width, int height);
+	operator bool() const { return context != EGL_NO_CONTEXT; }
+	// reads back the color attachment as tightly packed RGBA rows, bottom
+	// row first.
+	std::vector<unsigned char> readPixels();
+	// writes the color attachment to a binary PPM, top row first.
+	bool writePPM(const char* path);
+	void destroy();
+};
@@ -0,0 +1,179 @@
+#include "atlas.hpp"
+#include "headless.hpp"
+#include "renderer.hpp"
+#include "texcache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// two images loading on units 0 and 1 are bound and a frame is drawn
+// before poll() uploads them, like the first frames of the window, where
+// the active unit is left on whatever the frame bound last. each texture
+// has to end up with its own image, at base level 0.
+static bool checkPollAfterDraw(Renderer& r) {
+	const char* paths[] = {"resources/trollcake.jpg", "resources/derpina.jpg"};
+	auto loader = TextureLoader::create();
+	Texture textures[2];
+	for (int i = 0; i < 2; ++i)
+		textures[i] = loader.load(paths[i], GL_TEXTURE0 + i);
+	for (auto& texture : textures) texture.bind();
+	r.process(1.f / 60.f, glm::vec4(.3f, .3f, .3f, 1.f));
+	textures[1].bind();
+	loader.finish();
+
+	bool ok = true;
+	for (int i = 0; i < 2; ++i) {
+		int width, height, channels;
+		auto expected = stbi_load(paths[i], &width, &height, &channels, 4);
+		if (!expected) return false;
+		std::vector<unsigned char> actual((size_t)width * height * 4);
+		GLint base;
+		textures[i].bind();
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &base);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+			actual.data());
+		textures[i].unbind();
+		if (base != 0 || memcmp(actual.data(), expected, actual.size())) {
+			std::cout << "Texture on unit " << i << " doesn't hold "
+				<< paths[i] << " after poll()\n";
+			ok = false;
+		}
+		stbi_image_free(expected);
+	}
+	for (auto& texture : textures) {
+		glDeleteTextures(1, &texture.id);
+		glState.forgetTexture(texture.id);
+	}
+	return ok;
+}
+
+// usage: headless [width] [height] [frames] [output.ppm]
+// packs two small images with padding 4 and checks the padding around the
+// second one holds copies of its edge pixels.
+static bool checkAtlasPadding() {
+	const int sizes[2][2] = {{5, 3}, {7, 6}};
+	std::vector<unsigned char> pixels[2];
+	std::vector<AtlasImage> images;
+	for (int i = 0; i < 2; ++i) {
+		int w = sizes[i][0], h = sizes[i][1];
+		pixels[i].resize((size_t)w * h * 4);
+		for (int y = 0; y < h; ++y)
+			for (int x = 0; x < w; ++x) {
+				auto texel = &pixels[i][((size_t)y * w + x) * 4];
+				texel[0] = (unsigned char)(40 * x + 1);
+				texel[1] = (unsigned char)(40 * y + 1);
+				texel[2] = (unsigned char)(100 * i + 7);
+				texel[3] = 255;
+			}
+		images.push_back({pixels[i].data(), w, h});
+	}
+	auto atlas = TextureAtlas::create(images, GL_TEXTURE0, 4);
+	if (!atlas || atlas.stats.packed != 2) {
+		std::cout << "Couldn't pack the atlas padding check\n";
+		return false;
+	}
+
+	std::vector<unsigned char> actual((size_t)atlas.width * atlas.height * 4);
+	atlas.texture.bind();
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, actual.data());
+	atlas.texture.unbind();
+
+	const int w = sizes[1][0], h = sizes[1][1], padding = atlas.padding;
+	const auto& region = atlas.regions[1];
+	int left = (int)(region.offset.x * atlas.width + .5f),
+		top = (int)(region.offset.y * atlas.height + .5f);
+	int wrong = 0;
+	for (int y = -padding; y < h + padding; ++y)
+		for (int x = -padding; x < w + padding; ++x) {
+			if (x >= 0 && x < w && y >= 0 && y < h) continue;
+			int sx = std::clamp(x, 0, w - 1), sy = std::clamp(y, 0, h - 1);
+			auto expected = &pixels[1][((size_t)sy * w + sx) * 4];
+			auto texel = &actual[((size_t)(top + y) * atlas.width + left + x)
+				* 4];
+			if (memcmp(texel, expected, 4)) wrong++;
+		}
+	if (wrong)
+		std::cout << wrong << " padding texels around atlas region 1 don't "
+			"match its edge\n";
+	glDeleteTextures(1, &atlas.texture.id);
+	glState.forgetTexture(atlas.texture.id);
+	return !wrong;
+}
+
+// loads one image twice by path and once as a byte-identical copy under
+// another name, then drops every reference and lowers the budget so the
+// one shared texture gets evicted.
+static bool checkTextureCache() {
+	const char* path = "resources/derpina.jpg";
+	auto copy = (std::filesystem::temp_directory_path()
+		/ "headless_derpina_copy.jpg").string();
+	std::error_code error;
+	std::filesystem::copy_file(path, copy,
+		std::filesystem::copy_options::overwrite_existing, error);
+	if (error) {
+		std::cout << "Failed to copy " << path << " for the cache check\n";
+		return false;
+	}
+
+	auto loader = TextureLoader::create();
+	bool ok;
+	{
+		auto cache = TextureCache::create(loader);
+		{
+			auto first = cache.load(path, GL_TEXTURE0);
+			auto second = cache.load(path, GL_TEXTURE0);
+			auto third = cache.load(copy.c_str(), GL_TEXTURE0);
+			loader.finish();
+			ok = first && first.texture.id == second.texture.id
+				&& first.texture.id == third.texture.id;
+		}
+		cache.setBudget(1);
+		auto& stats = cache.stats();
+		ok = ok && stats.hits == 1 && stats.contentHits == 1
+			&& stats.misses == 1 && stats.evictions == 1
+			&& stats.textures == 0 && stats.residentBytes == 0;
+		if (!ok)
+			std::cout << "Texture cache: " << stats.hits << " hits, "
+				<< stats.contentHits << " content hits, " << stats.misses
+				<< " misses, " << stats.evictions << " evictions, expected "
+				"1 of each\n";
+	}
+	std::filesystem::remove(copy, error);
+	return ok;
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 800,
+		height = argc > 2 ? atoi(argv[2]) : 600,
+		frames = argc > 3 ? atoi(argv[3]) : 1;
+	const char* outPath = argc > 4 ? argv[4] : "frame.ppm";
+
+	auto context = HeadlessContext::create(width, height);
+	if (!context) {
+		LOG("Failed to create headless context\n");
+		return -1;
+	}
+	bool ok;
+	{
+		auto r = Renderer(glm::vec2((float)width, (float)height));
+		r.textures.finish();
+		const Seconds delta = 1.f / 60.f;
+		for (int i = 0; i < frames; ++i)
+			r.process(delta, glm::vec4(.3f, .3f, .3f, 1.f));
+		glFinish();
+		if (!context.writePPM(outPath))
+			std::cout << "Failed to write " << outPath << '\n';
+		// after the frames, the extra one it draws isn't in the image.
+		ok = checkPollAfterDraw(r);
+		ok = checkAtlasPadding() && ok;
+		ok = checkTextureCache() && ok;
+	}
+	context.destroy();
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,772 @@
+#include "importer.hpp"
+#include "mappedfile.hpp"
+#include "meshfile.hpp"
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start)
+		.count();
+}
+
+static bool endsWith(const std::string& s, const char* suffix) {
+	size_t n = strlen(suffix);
+	if (s.size() < n) return false;
+	for (size_t i = 0; i < n; ++i)
+		if (tolower(s[s.size() - n + i]) != suffix[i]) return false;
+	return true;
+}
+
+// OBJ
+
+namespace {
+
+// what one thread parsed out of its part of the file. corners hold
+// (position, uv) pairs of triangle corners, 0 based and absolute, with -1
+// for a missing uv; relative (negative) indices are counted from the
+// chunk's start and listed in relativePositions/relativeUvs, to be offset
+// once the counts of the chunks before are known.
+struct ObjChunk {
+	std::vector<float> positions, uvs;
+	std::vector<int> corners;
+	std::vector<uint32_t> relativePositions, relativeUvs;
+	size_t faceCorners = 0;
+	bool ok = true;
+};
+
+struct LineParser {
+	const char* p;
+	const char* end;
+	void skipSpaces() {
+		while (p < end && (*p == ' ' || *p == '\t')) ++p;
+	}
+	bool atEnd() {
+		skipSpaces();
+		return p >= end;
+	}
+	bool number(float& out) {
+		skipSpaces();
+		auto result = std::from_chars(p, end, out);
+		if (result.ec != std::errc()) return false;
+		p = result.ptr;
+		return true;
+	}
+	bool integer(int& out) {
+		auto result = std::from_chars(p, end, out);
+		if (result.ec != std::errc()) return false;
+		p = result.ptr;
+		return true;
+	}
+};
+
+} // namespace
+
+static void parseObjLine(ObjChunk& chunk, LineParser line,
+	std::vector<int>& polygon) {
+	line.skipSpaces();
+	if (line.end - line.p < 2) return;
+	if (line.p[0] == 'v' && (line.p[1] == ' ' || line.p[1] == '\t')) {
+		line.p += 2;
+		float xyz[3];
+		for (auto& c : xyz) chunk.ok &= line.number(c);
+		chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+	} else if (line.p[0] == 'v' && line.p[1] == 't') {
+		line.p += 2;
+		// v is optional and defaults to 0.
+		float uv[2] = {0.f, 0.f};
+		chunk.ok &= line.number(uv[0]);
+		if (!line.atEnd()) chunk.ok &= line.number(uv[1]);
+		chunk.uvs.insert(chunk.uvs.end(), uv, uv + 2);
+	} else if (line.p[0] == 'f' && (line.p[1] == ' ' || line.p[1] == '\t')) {
+		line.p += 2;
+		polygon.clear();
+		int positionCount = chunk.positions.size() / 3,
+			uvCount = chunk.uvs.size() / 2;
+		while (!line.atEnd()) {
+			int position = 0, uv = 0, normal = 0;
+			if (!line.integer(position)) break;
+			if (line.p < line.end && *line.p == '/') {
+				++line.p;
+				if (line.p < line.end && *line.p != '/' && !line.integer(uv))
+					break;
+				if (line.p < line.end && *line.p == '/') {
+					++line.p;
+					if (!line.integer(normal)) break;
+				}
+			}
+			// 1 based, negative counts back from the last vertex so far.
+			// the third entry flags which of the two were relative.
+			polygon.push_back(position > 0 ? position - 1
+				: position < 0 ? positionCount + position : -1);
+			polygon.push_back(uv > 0 ? uv - 1
+				: uv < 0 ? uvCount + uv : -1);
+			polygon.push_back((position < 0) | (uv < 0) << 1);
+		}
+		// a token that didn't parse stopped the loop early.
+		if (!line.atEnd()) {
+			chunk.ok = false;
+			return;
+		}
+		size_t n = polygon.size() / 3;
+		if (n < 3) {
+			chunk.ok &= n == 0;
+			return;
+		}
+		auto corner = [&](size_t i) {
+			uint32_t at = chunk.corners.size();
+			chunk.corners.push_back(polygon[i * 3]);
+			chunk.corners.push_back(polygon[i * 3 + 1]);
+			if (polygon[i * 3 + 2] & 1) chunk.relativePositions.push_back(at);
+			if (polygon[i * 3 + 2] & 2) chunk.relativeUvs.push_back(at + 1);
+		};
+		for (size_t i = 2; i < n; ++i) {
+			corner(0);
+			corner(i - 1);
+			corner(i);
+		}
+		chunk.faceCorners += n;
+	}
+}
+
+static void parseObjChunk(ObjChunk& chunk, const char* begin,
+	const char* end) {
+	std::vector<int> polygon;
+	const char* p = begin;
+	while (p < end) {
+		auto lineEnd = (const char*)memchr(p, '\n', end - p);
+		if (!lineEnd) lineEnd = end;
+		auto stop = lineEnd;
+		if (stop > p && stop[-1] == '\r') --stop;
+		parseObjLine(chunk, {p, stop}, polygon);
+		p = lineEnd + 1;
+	}
+}
+
+ImportedMesh ImportedMesh::fromObj(const char* path, int threads) {
+	ImportedMesh out;
+	auto start = Clock::now();
+	auto file = MappedFile::open(path);
+	if (!file) return out;
+	auto text = (const char*)file.data;
+	out.stats.sourceBytes = file.size;
+
+	if (threads <= 0) threads = std::thread::hardware_concurrency();
+	// chunks under 1 MiB aren't worth a thread.
+	threads = std::clamp<int>(file.size >> 20, 1, std::max(threads, 1));
+	out.stats.threads = threads;
+	std::vector<const char*> bounds{text};
+	for (int t = 1; t < threads; ++t) {
+		const char* p = text + file.size * t / threads;
+		p = std::max(p, bounds.back());
+		auto newline = (const char*)memchr(p, '\n', text + file.size - p);
+		bounds.push_back(newline ? newline + 1 : text + file.size);
+	}
+	bounds.push_back(text + file.size);
+
+	std::vector<ObjChunk> chunks(threads);
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; ++t)
+		workers.emplace_back(parseObjChunk, std::ref(chunks[t]), bounds[t],
+			bounds[t + 1]);
+	parseObjChunk(chunks[0], bounds[0], bounds[1]);
+	for (auto& worker : workers) worker.join();
+
+	// resolve chunk relative indices and concatenate.
+	std::vector<float> positions, uvs;
+	std::vector<int> corners;
+	for (auto& chunk : chunks) {
+		if (!chunk.ok) {
+			std::cout << "Failed to parse " << path << '\n';
+			return out;
+		}
+		int positionBase = positions.size() / 3, uvBase = uvs.size() / 2;
+		for (uint32_t at : chunk.relativePositions)
+			chunk.corners[at] += positionBase;
+		for (uint32_t at : chunk.relativeUvs) {
+			// anything below 0 would be taken for a missing uv.
+			if ((chunk.corners[at] += uvBase) < 0) {
+				std::cout << path << ": face index out of range\n";
+				return out;
+			}
+		}
+		positions.insert(positions.end(), chunk.positions.begin(),
+			chunk.positions.end());
+		uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+		corners.insert(corners.end(), chunk.corners.begin(),
+			chunk.corners.end());
+		out.stats.sourceVertices += chunk.faceCorners;
+		chunk = {};
+	}
+	out.stats.parseMs = msSince(start);
+
+	start = Clock::now();
+	int positionCount = positions.size() / 3, uvCount = uvs.size() / 2;
+	std::unordered_map<uint64_t, int> merged;
+	merged.reserve(positionCount * 2);
+	out.indices.reserve(corners.size() / 2);
+	for (size_t c = 0; c < corners.size(); c += 2) {
+		int position = corners[c], uv = corners[c + 1];
+		if (position < 0 || position >= positionCount || uv >= uvCount) {
+			std::cout << path << ": face index out of range\n";
+			return out;
+		}
+		uint64_t key = (uint64_t)position << 32 | (uint32_t)(uv + 1);
+		auto [it, added] = merged.try_emplace(key,
+			out.vertices.size() / 5);
+		if (added) {
+			out.vertices.insert(out.vertices.end(), &positions[position * 3],
+				&positions[position * 3] + 3);
+			if (uv >= 0)
+				out.vertices.insert(out.vertices.end(), &uvs[uv * 2],
+					&uvs[uv * 2] + 2);
+			else
+				out.vertices.insert(out.vertices.end(), {0.f, 0.f});
+		}
+		out.indices.push_back(it->second);
+	}
+	out.stats.dedupMs = msSince(start);
+	out.ok = true;
+	return out;
+}
+
+// glTF
+
+namespace {
+
+// just enough JSON for glTF: numbers are doubles, objects keep their
+// members in order and are searched linearly.
+struct Json {
+	enum Type : uint8_t { null, boolean, number, string, array, object };
+	Type type = null;
+	double value = 0.;
+	std::string text;
+	std::vector<Json> items;
+	std::vector<std::string> keys;
+
+	const Json& operator[](const char* key) const {
+		static const Json missing;
+		for (size_t i = 0; i < keys.size(); ++i)
+			if (keys[i] == key) return items[i];
+		return missing;
+	}
+	// int rather than size_t, so [0] isn't read as a null key.
+	const Json& operator[](int i) const {
+		static const Json missing;
+		return type == array && i >= 0 && (size_t)i < items.size() ? items[i]
+			: missing;
+	}
+	size_t size() const { return type == array ? items.size() : 0; }
+	bool has(const char* key) const { return (*this)[key].type != null; }
+	double real(double fallback = 0.) const {
+		return type == number ? value : fallback;
+	}
+	int integer(int fallback = -1) const {
+		return type == number ? (int)value : fallback;
+	}
+	// for counts and byte offsets: false unless absent (out = fallback) or
+	// a whole number in [0, 2^32), so sizes computed from it can't wrap.
+	bool unsignedInteger(size_t& out, size_t fallback = 0) const {
+		if (type == null) {
+			out = fallback;
+			return true;
+		}
+		if (type != number || value < 0. || value >= 4294967296.
+			|| value != std::floor(value))
+			return false;
+		out = (size_t)value;
+		return true;
+	}
+};
+
+struct JsonParser {
+	const char* p;
+	const char* end;
+	bool ok = true;
+
+	void skipSpaces() {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+			++p;
+	}
+	bool consume(char c) {
+		skipSpaces();
+		if (p < end && *p == c) {
+			++p;
+			return true;
+		}
+		return false;
+	}
+	bool literal(const char* word) {
+		size_t n = strlen(word);
+		if ((size_t)(end - p) < n || strncmp(p, word, n)) return false;
+		p += n;
+		return true;
+	}
+	std::string string() {
+		std::string out;
+		if (!consume('"')) {
+			ok = false;
+			return out;
+		}
+		while (p < end && *p != '"') {
+			if (*p == '\\' && p + 1 < end) {
+				++p;
+				switch (*p) {
+				case 'n': out += '\n'; break;
+				case 't': out += '\t'; break;
+				case 'r': out += '\r'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				// glTF names and uris are ascii in practice, other code
+				// points are kept escaped.
+				case 'u': out += "\\u"; break;
+				default: out += *p;
+				}
+			} else {
+				out += *p;
+			}
+			++p;
+		}
+		ok &= consume('"');
+		return out;
+	}
+	Json parse(int depth = 0) {
+		Json out;
+		skipSpaces();
+		if (p >= end || depth > 64) {
+			ok = false;
+			return out;
+		}
+		if (*p == '{') {
+			++p;
+			out.type = Json::object;
+			if (consume('}')) return out;
+			do {
+				out.keys.push_back(string());
+				ok &= consume(':');
+				out.items.push_back(parse(depth + 1));
+			} while (ok && consume(','));
+			ok &= consume('}');
+		} else if (*p == '[') {
+			++p;
+			out.type = Json::array;
+			if (consume(']')) return out;
+			do out.items.push_back(parse(depth + 1));
+			while (ok && consume(','));
+			ok &= consume(']');
+		} else if (*p == '"') {
+			out.type = Json::string;
+			out.text = string();
+		} else if (literal("true")) {
+			out.type = Json::boolean;
+			out.value = 1.;
+		} else if (literal("false")) {
+			out.type = Json::boolean;
+		} else if (literal("null")) {
+		} else {
+			out.type = Json::number;
+			auto result = std::from_chars(p, end, out.value);
+			ok &= result.ec == std::errc();
+			p = result.ptr;
+		}
+		return out;
+	}
+};
+
+struct GltfBuffer {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+};
+
+// an accessor resolved to a strided view into its buffer.
+struct GltfAccessor {
+	const uint8_t* data = nullptr;
+	size_t count = 0, stride = 0;
+	int componentType = 0, components = 0;
+	bool normalized = false;
+
+	float component(size_t element, int c) const {
+		const uint8_t* p = data + element * stride;
+		switch (componentType) {
+		case GL_FLOAT: {
+			float f;
+			memcpy(&f, p + c * 4, 4);
+			return f;
+		}
+		case GL_BYTE: {
+			auto v = (int8_t)p[c];
+			return normalized ? std::max(v / 127.f, -1.f) : v;
+		}
+		case GL_UNSIGNED_BYTE:
+			return normalized ? p[c] / 255.f : p[c];
+		case GL_SHORT: {
+			int16_t v;
+			memcpy(&v, p + c * 2, 2);
+			return normalized ? std::max(v / 32767.f, -1.f) : v;
+		}
+		case GL_UNSIGNED_SHORT: {
+			uint16_t v;
+			memcpy(&v, p + c * 2, 2);
+			return normalized ? v / 65535.f : v;
+		}
+		case GL_UNSIGNED_INT: {
+			uint32_t v;
+			memcpy(&v, p + c * 4, 4);
+			return v;
+		}
+		}
+		return 0.f;
+	}
+	uint32_t index(size_t element) const {
+		const uint8_t* p = data + element * stride;
+		if (componentType == GL_UNSIGNED_BYTE) return *p;
+		if (componentType == GL_UNSIGNED_SHORT) {
+			uint16_t v;
+			memcpy(&v, p, 2);
+			return v;
+		}
+		uint32_t v;
+		memcpy(&v, p, 4);
+		return v;
+	}
+};
+
+struct VertexKey {
+	float v[5];
+	bool operator==(const VertexKey& other) const {
+		return !memcmp(v, other.v, sizeof(v));
+	}
+};
+
+struct VertexKeyHash {
+	size_t operator()(const VertexKey& key) const {
+		// FNV-1a over the bytes.
+		uint64_t hash = 0xcbf29ce484222325;
+		auto bytes = (const uint8_t*)key.v;
+		for (size_t i = 0; i < sizeof(key.v); ++i)
+			hash = (hash ^ bytes[i]) * 0x100000001b3;
+		return hash;
+	}
+};
+
+} // namespace
+
+static int componentCount(const std::string& type) {
+	if (type == "SCALAR") return 1;
+	if (type == "VEC2") return 2;
+	if (type == "VEC3") return 3;
+	if (type == "VEC4") return 4;
+	return 0;
+}
+
+static int componentSize(int componentType) {
+	switch (componentType) {
+	case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+	case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+	case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+	}
+	return 0;
+}
+
+static bool resolveAccessor(const Json& gltf,
+	const std::vector<GltfBuffer>& buffers, int index, GltfAccessor& out) {
+	const Json& accessor = gltf["accessors"][index];
+	if (accessor.type != Json::object || accessor.has("sparse")) return false;
+	const Json& view = gltf["bufferViews"][accessor["bufferView"].integer()];
+	int buffer = view["buffer"].integer();
+	if (buffer < 0 || buffer >= (int)buffers.size()) return false;
+	size_t viewOffset, viewLength, offset;
+	if (!accessor["count"].unsignedInteger(out.count)
+		|| !view["byteStride"].unsignedInteger(out.stride)
+		|| !view["byteOffset"].unsignedInteger(viewOffset)
+		|| !view["byteLength"].unsignedInteger(viewLength)
+		|| !accessor["byteOffset"].unsignedInteger(offset))
+		return false;
+	out.componentType = accessor["componentType"].integer(0);
+	out.components = componentCount(accessor["type"].text);
+	out.normalized = accessor["normalized"].value != 0.;
+	size_t elementSize = out.components * componentSize(out.componentType);
+	if (!out.stride) out.stride = elementSize;
+	size_t bufferSize = buffers[buffer].size;
+	if (!elementSize || viewOffset > bufferSize
+		|| viewLength > bufferSize - viewOffset || offset > viewLength)
+		return false;
+	// the last element has to end inside the view.
+	size_t room = viewLength - offset;
+	if (out.count && (elementSize > room
+		|| (out.count - 1) * out.stride > room - elementSize))
+		return false;
+	out.data = buffers[buffer].data + viewOffset + offset;
+	return true;
+}
+
+static std::vector<uint8_t> decodeBase64(const char* p, const char* end) {
+	std::vector<uint8_t> out;
+	uint32_t bits = 0;
+	int count = 0;
+	for (; p < end && *p != '='; ++p) {
+		int v = *p >= 'A' && *p <= 'Z' ? *p - 'A'
+			: *p >= 'a' && *p <= 'z' ? *p - 'a' + 26
+			: *p >= '0' && *p <= '9' ? *p - '0' + 52
+			: *p == '+' ? 62 : *p == '/' ? 63 : -1;
+		if (v < 0) continue;
+		bits = bits << 6 | v;
+		count += 6;
+		if (count >= 8) {
+			count -= 8;
+			out.push_back(bits >> count & 0xFF);
+		}
+	}
+	return out;
+}
+
+static glm::mat4 nodeTransform(const Json& node) {
+	const Json& matrix = node["matrix"];
+	if (matrix.size() == 16) {
+		glm::mat4 out;
+		for (int i = 0; i < 16; ++i) out[i / 4][i % 4] = matrix[i].real();
+		return out;
+	}
+	glm::mat4 out(1.f);
+	const Json &t = node["translation"], &r = node["rotation"],
+		&s = node["scale"];
+	if (t.size() == 3)
+		out = glm::translate(out, glm::vec3(t[0].real(), t[1].real(),
+			t[2].real()));
+	if (r.size() == 4)
+		out *= glm::mat4_cast(glm::quat((float)r[3].real(),
+			(float)r[0].real(), (float)r[1].real(), (float)r[2].real()));
+	if (s.size() == 3)
+		out = glm::scale(out, glm::vec3(s[0].real(), s[1].real(),
+			s[2].real()));
+	return out;
+}
+
+ImportedMesh ImportedMesh::fromGltf(const char* path) {
+	ImportedMesh out;
+	out.stats.threads = 1;
+	auto start = Clock::now();
+	auto file = MappedFile::open(path);
+	if (!file) return out;
+	out.stats.sourceBytes = file.size;
+	auto fail = [&](const char* reason) {
+		std::cout << path << ": " << reason << '\n';
+		return ImportedMesh{};
+	};
+
+	// .glb: 12 byte header, then a JSON chunk and an optional BIN chunk.
+	const char* jsonBegin = (const char*)file.data;
+	const char* jsonEnd = jsonBegin + file.size;
+	GltfBuffer glbBuffer;
+	if (file.size >= 20 && !memcmp(file.data, "glTF", 4)) {
+		uint32_t jsonLength;
+		memcpy(&jsonLength, file.data + 12, 4);
+		if (20 + (size_t)jsonLength > file.size
+			|| memcmp(file.data + 16, "JSON", 4))
+			return fail("bad glb header");
+		jsonBegin = (const char*)file.data + 20;
+		jsonEnd = jsonBegin + jsonLength;
+		size_t binAt = 20 + ((jsonLength + 3) & ~3u);
+		if (binAt + 8 <= file.size && !memcmp(file.data + binAt + 4, "BIN", 4)) {
+			uint32_t binLength;
+			memcpy(&binLength, file.data + binAt, 4);
+			glbBuffer.data = file.data + binAt + 8;
+			glbBuffer.size = std::min<size_t>(binLength, file.size - binAt - 8);
+		}
+	}
+	JsonParser parser{jsonBegin, jsonEnd};
+	Json gltf = parser.parse();
+	if (!parser.ok || gltf.type != Json::object) return fail("bad JSON");
+
+	// buffers are mapped when external, decoded when embedded.
+	std::vector<GltfBuffer> buffers;
+	std::vector<MappedFile> mappedBuffers;
+	std::vector<std::vector<uint8_t>> decodedBuffers;
+	mappedBuffers.reserve(gltf["buffers"].size());
+	decodedBuffers.reserve(gltf["buffers"].size());
+	auto directory = std::filesystem::path(path).parent_path();
+	for (size_t b = 0; b < gltf["buffers"].size(); ++b) {
+		const std::string& uri = gltf["buffers"][b]["uri"].text;
+		if (uri.empty()) {
+			buffers.push_back(glbBuffer);
+		} else if (!uri.compare(0, 5, "data:")) {
+			auto comma = uri.find(";base64,");
+			if (comma == std::string::npos) return fail("unsupported data uri");
+			decodedBuffers.push_back(decodeBase64(uri.data() + comma + 8,
+				uri.data() + uri.size()));
+			buffers.push_back({decodedBuffers.back().data(),
+				decodedBuffers.back().size()});
+		} else {
+			mappedBuffers.push_back(MappedFile::open(
+				(directory / uri).string().c_str()));
+			if (!mappedBuffers.back()) return fail("missing buffer");
+			buffers.push_back({mappedBuffers.back().data,
+				mappedBuffers.back().size});
+		}
+	}
+
+	std::unordered_map<VertexKey, int, VertexKeyHash> merged;
+	double dedupMs = 0.;
+	bool ok = true;
+	auto addMesh = [&](const Json& mesh, const glm::mat4& transform) {
+		for (size_t p = 0; p < mesh["primitives"].size(); ++p) {
+			const Json& primitive = mesh["primitives"][p];
+			// only triangle lists.
+			if (primitive["mode"].integer(4) != 4) continue;
+			const Json& attributes = primitive["attributes"];
+			GltfAccessor positions, uvs, indices;
+			if (!resolveAccessor(gltf, buffers,
+				attributes["POSITION"].integer(), positions)
+				|| positions.components != 3
+				|| positions.componentType != GL_FLOAT) {
+				ok = false;
+				return;
+			}
+			bool hasUvs = attributes.has("TEXCOORD_0") && resolveAccessor(gltf,
+				buffers, attributes["TEXCOORD_0"].integer(), uvs)
+				&& uvs.components == 2 && uvs.count == positions.count;
+			bool indexed = primitive.has("indices");
+			if (indexed && (!resolveAccessor(gltf, buffers,
+				primitive["indices"].integer(), indices)
+				|| indices.components != 1
+				|| (indices.componentType != GL_UNSIGNED_BYTE
+					&& indices.componentType != GL_UNSIGNED_SHORT
+					&& indices.componentType != GL_UNSIGNED_INT))) {
+				ok = false;
+				return;
+			}
+			size_t corners = indexed ? indices.count : positions.count;
+			out.stats.sourceVertices += corners;
+			auto dedupStart = Clock::now();
+			std::vector<int> remap(positions.count, -1);
+			for (size_t c = 0; c < corners; ++c) {
+				size_t i = indexed ? indices.index(c) : c;
+				if (i >= positions.count) {
+					ok = false;
+					return;
+				}
+				if (remap[i] < 0) {
+					auto pos = glm::vec3(transform * glm::vec4(
+						positions.component(i, 0), positions.component(i, 1),
+						positions.component(i, 2), 1.f));
+					// glTF's uv origin is the top left.
+					VertexKey key{{pos.x, pos.y, pos.z,
+						hasUvs ? uvs.component(i, 0) : 0.f,
+						hasUvs ? 1.f - uvs.component(i, 1) : 0.f}};
+					auto [it, added] = merged.try_emplace(key,
+						out.vertices.size() / 5);
+					if (added)
+						out.vertices.insert(out.vertices.end(), key.v, key.v + 5);
+					remap[i] = it->second;
+				}
+				out.indices.push_back(remap[i]);
+			}
+			dedupMs += msSince(dedupStart);
+		}
+	};
+	std::vector<bool> visiting(gltf["nodes"].size());
+	auto addNode = [&](auto& self, int index, const glm::mat4& parent) {
+		const Json& node = gltf["nodes"][index];
+		if (node.type != Json::object || visiting[index]) return;
+		visiting[index] = true;
+		auto transform = parent * nodeTransform(node);
+		if (node.has("mesh"))
+			addMesh(gltf["meshes"][node["mesh"].integer()], transform);
+		for (size_t c = 0; c < node["children"].size(); ++c)
+			self(self, node["children"][c].integer(), transform);
+		visiting[index] = false;
+	};
+	const Json& scene = gltf["scenes"][gltf["scene"].integer(0)];
+	if (scene.type == Json::object) {
+		for (size_t n = 0; n < scene["nodes"].size(); ++n)
+			addNode(addNode, scene["nodes"][n].integer(), glm::mat4(1.f));
+	} else {
+		// no scene, take the meshes as they are.
+		for (size_t m = 0; m < gltf["meshes"].size(); ++m)
+			addMesh(gltf["meshes"][m], glm::mat4(1.f));
+	}
+	if (!ok) return fail("bad accessor");
+	out.stats.dedupMs = dedupMs;
+	out.stats.parseMs = msSince(start) - dedupMs;
+	out.ok = true;
+	return out;
+}
+
+ImportedMesh ImportedMesh::load(const char* path, int threads) {
+	std::string name = path;
+	if (endsWith(name, ".obj")) return fromObj(path, threads);
+	if (endsWith(name, ".gltf") || endsWith(name, ".glb")) return fromGltf(path);
+	std::cout << "Unknown mesh file type " << path << '\n';
+	return {};
+}
+
+// cache
+
+static std::string cachePath(const char* path, const VertexFormat& format,
+	const char* cacheDir) {
+	namespace fs = std::filesystem;
+	std::error_code error;
+	auto absolute = fs::absolute(path, error).string();
+	uint64_t size = fs::file_size(path, error);
+	if (error) return {};
+	uint64_t time = fs::last_write_time(path, error).time_since_epoch().count();
+	if (error) return {};
+	uint64_t hash = 0xcbf29ce484222325;
+	auto mix = [&](const void* data, size_t bytes) {
+		for (size_t i = 0; i < bytes; ++i)
+			hash = (hash ^ ((const uint8_t*)data)[i]) * 0x100000001b3;
+	};
+	mix(absolute.data(), absolute.size());
+	mix(&size, sizeof(size));
+	mix(&time, sizeof(time));
+	for (auto& attrib : format.attribs) {
+		uint32_t fields[] = {attrib.location, (uint32_t)attrib.components,
+			(uint32_t)attrib.type};
+		mix(fields, sizeof(fields));
+	}
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)hash);
+	return (fs::path(cacheDir) / name).string();
+}
+
+Mesh importMesh(const char* path, const VertexFormat& format,
+	MeshStorage storage, const char* cacheDir) {
+	// keep needs the authored floats, which the cache doesn't have.
+	std::string cached;
+	if (cacheDir && storage != MeshStorage::keep)
+		cached = cachePath(path, format, cacheDir);
+	if (!cached.empty() && std::filesystem::exists(cached)) {
+		auto file = MeshFile::open(cached.c_str());
+		if (file && file.format == format) {
+			LOG("importMesh: %s from %s\n", path, cached.c_str());
+			return file.upload(storage);
+		}
+	}
+
+	auto imported = ImportedMesh::load(path);
+	if (!imported) return {};
+	LOG("importMesh: %s, %zu bytes, %zu -> %zu vertices in %.2f + %.2f ms "
+		"on %d threads\n", path, imported.stats.sourceBytes,
+		imported.stats.sourceVertices, imported.vertices.size() / 5,
+		imported.stats.parseMs, imported.stats.dedupMs, imported.stats.threads);
+	if (!cached.empty()
+		&& MeshFile::write(cached.c_str(), imported.vertices, imported.indices,
+			format)) {
+		auto file = MeshFile::open(cached.c_str());
+		if (file) return file.upload(storage);
+	}
+	return Mesh::create(std::move(imported.vertices),
+		std::move(imported.indices), format, storage);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vertexformat.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+enum class MeshStorage : uint8_t;
+
+// Geometry read from an asset file, in the Mesh vertex layout: position
+// and uv, 5 floats per vertex, with uv origin at the bottom left like the
+// textures. Everything in the file is merged into one mesh; normals,
+// materials and other attributes are dropped.
+struct ImportedMesh {
+	struct Stats {
+		size_t sourceBytes;
+		// vertices as referenced by faces, before deduplication.
+		size_t sourceVertices;
+		int threads;
+		double parseMs, dedupMs;
+	};
+	std::vector<float> vertices;
+	std::vector<int> indices;
+	Stats stats{};
+	bool ok = false;
+	operator bool() const { return ok; }
+
+	// Wavefront OBJ: v, vt and f lines, polygons are fanned into
+	// triangles. The file is split into chunks at line boundaries and
+	// parsed in parallel; threads includes the calling one, 0 picks one
+	// per hardware thread. v/vt pairs are merged into vertices through a
+	// hash map.
+	static ImportedMesh fromObj(const char* path, int threads = 0);
+	// glTF 2.0, .gltf with external or base64 buffers, or .glb. Triangle
+	// primitives of every node in the default scene, with node transforms
+	// applied; identical vertices across primitives are merged.
+	static ImportedMesh fromGltf(const char* path);
+	// by extension.
+	static ImportedMesh load(const char* path, int threads = 0);
+};
+
+// imports path into a Mesh in format. The converted geometry is written to
+// cacheDir as a MeshFile named after the source's path, size and
+// modification time and the format, so later loads of an unchanged file
+// map the cache instead of parsing. cacheDir has to exist; nullptr
+// disables the cache. Returns an empty Mesh if the import fails.
+Mesh importMesh(const char* path, const VertexFormat& format,
+	MeshStorage storage, const char* cacheDir = "cache");
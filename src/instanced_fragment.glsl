@@ -0,0 +1,12 @@
+#version 330 core
+
+in vec2 texCoord;
+flat in uint texIndex;
+
+out vec4 FragColor;
+
+uniform sampler2DArray layers;
+
+void main() {
+	FragColor = texture(layers, vec3(texCoord, float(texIndex)));
+}
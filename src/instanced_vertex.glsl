@@ -0,0 +1,28 @@
+#version 330 core
+
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec2 resolution;
+	float time;
+};
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+// per instance, see InstanceData in instancing.hpp.
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in uint aTexIndex;
+
+out vec2 texCoord;
+flat out uint texIndex;
+
+void main() {
+	mat4 transform = viewProjection * aModel;
+
+	gl_Position = transform * (vec4(aPos, 1.0) + vec4(-.3, -.3, 0., 0.));
+	gl_Position.x *= resolution.y/resolution.x;
+	texCoord = aTexCoord;
+	texIndex = aTexIndex;
+}
@@ -0,0 +1,41 @@
+#include "instancing.hpp"
+#include "renderer.hpp"
+
+#include <cstddef>
+
+static_assert(InstanceData::Layout::stride == sizeof(InstanceData)
+	&& InstanceData::Layout::offsets[1] == offsetof(InstanceData, texIndex)
+	&& InstanceData::texIndexLocation == InstanceData::transformLocation + 4,
+	"InstanceData::Layout doesn't match the struct");
+
+InstanceBuffer InstanceBuffer::create(const Mesh& mesh, GLsizei capacity) {
+	InstanceBuffer out;
+	out.capacity = capacity;
+	glGenVertexArrays(1, &out.VAO);
+	glGenBuffers(1, &out.VBO);
+	// the arena's VAO is shared by every mesh of the format, instance
+	// attributes on it would leak into their draws.
+	glState.bindVertexArray(out.VAO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+	mesh.format.apply();
+	glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, out.VBO);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr,
+		GL_DYNAMIC_DRAW);
+	InstanceData::setAttribs();
+	return out;
+}
+
+void InstanceData::setAttribs() {
+	Layout::apply(transformLocation, 1);
+}
+
+void InstanceBuffer::update(const InstanceData* instances, GLsizei count) {
+	glState.bindBuffer(GL_ARRAY_BUFFER, VBO);
+	if (count > capacity) capacity = count;
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr,
+		GL_DYNAMIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData),
+		instances);
+	this->count = count;
+}
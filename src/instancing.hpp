@@ -0,0 +1,39 @@
+#pragma once
+
+#include "glm.hpp"
+#include "glstate.hpp"
+#include "layout.hpp"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+struct Mesh;
+
+// per-instance vertex attributes. the transform's columns are read from
+// locations 2-5 and the texture index from location 6, advancing once per
+// instance.
+struct InstanceData {
+	static constexpr GLuint transformLocation = 2, texIndexLocation = 6;
+	using Layout = ::Layout<Attr<glm::mat4>, Attr<GLuint, asInteger>>;
+	glm::mat4 transform;
+	// layer of the instanced material's array texture.
+	GLuint texIndex;
+	// points the instance attributes at the bound ARRAY_BUFFER, on the
+	// bound VAO.
+	static void setAttribs();
+};
+
+// a buffer of InstanceData with its own VAO, reading the mesh's vertices
+// from its arena block next to the instance attributes. drawn with
+// glDrawElementsInstancedBaseVertex by DrawList.
+struct InstanceBuffer {
+	GLuint VAO = 0, VBO = 0;
+	GLsizei count = 0, capacity = 0;
+	static InstanceBuffer create(const Mesh& mesh, GLsizei capacity);
+	// grows the buffer if needed, otherwise orphans and refills it.
+	void update(const InstanceData* instances, GLsizei count);
+	void update(const std::vector<InstanceData>& instances) {
+		update(instances.data(), instances.size());
+	}
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "glm.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Compile-time vertex layouts: strides and offsets come from the C++ types,
+// so setting up a VAO takes no GL queries.
+//
+//	using PosUv = Layout<Attr<glm::vec3>, Attr<glm::vec2>>;
+//	static_assert(PosUv::stride == 20);
+//	PosUv::apply(); // locations 0 and 1 on the bound VAO and ARRAY_BUFFER
+
+enum AttrMode {
+	// components converted to float as they are.
+	asFloat,
+	// integer components scaled to [0, 1] or [-1, 1].
+	asNormalized,
+	// integer components read by int/uint shader inputs.
+	asInteger,
+};
+
+// n 16 bit floats, as stored by glm::packHalf1x16.
+template <int N>
+struct Half {
+	uint16_t bits[N];
+};
+
+template <GLenum Type, GLint Components, GLuint Locations = 1>
+struct AttrTraitsBase {
+	static constexpr GLenum type = Type;
+	static constexpr GLint components = Components;
+	// matrices take one location per column.
+	static constexpr GLuint locations = Locations;
+};
+
+template <class T> struct AttrTraits;
+template <> struct AttrTraits<float> : AttrTraitsBase<GL_FLOAT, 1> {};
+template <> struct AttrTraits<int8_t> : AttrTraitsBase<GL_BYTE, 1> {};
+template <> struct AttrTraits<uint8_t> : AttrTraitsBase<GL_UNSIGNED_BYTE, 1> {};
+template <> struct AttrTraits<int16_t> : AttrTraitsBase<GL_SHORT, 1> {};
+template <> struct AttrTraits<uint16_t> : AttrTraitsBase<GL_UNSIGNED_SHORT, 1> {};
+template <> struct AttrTraits<int32_t> : AttrTraitsBase<GL_INT, 1> {};
+template <> struct AttrTraits<uint32_t> : AttrTraitsBase<GL_UNSIGNED_INT, 1> {};
+template <int N> struct AttrTraits<Half<N>> : AttrTraitsBase<GL_HALF_FLOAT, N> {};
+template <class T, glm::precision P>
+struct AttrTraits<glm::tvec2<T, P>> : AttrTraitsBase<AttrTraits<T>::type, 2> {};
+template <class T, glm::precision P>
+struct AttrTraits<glm::tvec3<T, P>> : AttrTraitsBase<AttrTraits<T>::type, 3> {};
+template <class T, glm::precision P>
+struct AttrTraits<glm::tvec4<T, P>> : AttrTraitsBase<AttrTraits<T>::type, 4> {};
+template <class T, glm::precision P>
+struct AttrTraits<glm::tmat3x3<T, P>> : AttrTraitsBase<AttrTraits<T>::type, 3, 3> {};
+template <class T, glm::precision P>
+struct AttrTraits<glm::tmat4x4<T, P>> : AttrTraitsBase<AttrTraits<T>::type, 4, 4> {};
+
+template <class T, AttrMode Mode = asFloat>
+struct Attr {
+	using type = T;
+	using traits = AttrTraits<T>;
+	static constexpr AttrMode mode = Mode;
+	static constexpr GLsizei size = sizeof(T);
+	static_assert(Mode == asFloat || (traits::type != GL_FLOAT
+		&& traits::type != GL_HALF_FLOAT), "only integers can be normalized "
+		"or read as integers");
+};
+
+template <class... Attrs>
+struct Layout {
+	static_assert(sizeof...(Attrs) > 0, "empty layout");
+	static constexpr size_t count = sizeof...(Attrs);
+	static constexpr GLsizei stride = (0 + ... + Attrs::size);
+	static constexpr GLuint locations = (0 + ... + Attrs::traits::locations);
+	static constexpr std::array<GLsizei, count> offsets = [] {
+		std::array<GLsizei, count> out{};
+		const GLsizei sizes[] = {Attrs::size...};
+		for (size_t i = 1; i < count; ++i) out[i] = out[i - 1] + sizes[i - 1];
+		return out;
+	}();
+
+	// points locations [firstLocation, firstLocation + locations) at the
+	// bound ARRAY_BUFFER on the bound VAO. divisor 1 advances them once
+	// per instance instead of per vertex.
+	static void apply(GLuint firstLocation = 0, GLuint divisor = 0) {
+		GLuint location = firstLocation;
+		size_t i = 0;
+		(setup<Attrs>(location, offsets[i++], divisor), ...);
+	}
+
+private:
+	template <class A>
+	static void setup(GLuint& location, GLsizei offset, GLuint divisor) {
+		using Traits = typename A::traits;
+		constexpr GLsizei columnSize = A::size / Traits::locations;
+		for (GLuint column = 0; column < Traits::locations; ++column) {
+			auto pointer = (GLvoid*)(uintptr_t)(offset + column * columnSize);
+			glEnableVertexAttribArray(location);
+			if constexpr (A::mode == asInteger)
+				glVertexAttribIPointer(location, Traits::components, Traits::type,
+					stride, pointer);
+			else
+				glVertexAttribPointer(location, Traits::components, Traits::type,
+					A::mode == asNormalized, stride, pointer);
+			glVertexAttribDivisor(location, divisor);
+			++location;
+		}
+	}
+};
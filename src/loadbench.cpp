@@ -0,0 +1,225 @@
+#include "headless.hpp"
+#include "importer.hpp"
+#include "meshfile.hpp"
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Mesh loading benchmark: writes an n x n grid as a mesh file, then loads
+// it into the arena repeatedly and prints MB/s of vertex and index data as
+// JSON, for three paths:
+//	mapped   MeshFile::open + upload, GL reads straight from the mapping
+//	read     the whole file read into memory, then uploaded from there
+//	authored Mesh::create from floats, packing on the CPU like cubeMesh()
+// Every run ends with glFinish, so the upload is included. --cold drops
+// the file from the page cache before each run (Linux only).
+//
+// Then the same grid is written as OBJ text (or --obj is used instead) and
+// imported on one thread, on every hardware thread, and through
+// importMesh's cache once it's warm, in MB/s of OBJ text.
+//
+// usage: loadbench [--size n] [--runs n] [--path file] [--obj file]
+//                  [--cold]
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start)
+		.count();
+}
+
+static void dropFromCache(const char* path) {
+#ifdef __linux__
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return;
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+#endif
+}
+
+// waits for the GPU and recycles what the run released.
+static void finishRun() {
+	glFinish();
+	MeshArena::endFrame();
+	glFinish();
+	MeshArena::endFrame();
+}
+
+int main(int argc, char** argv) {
+	int size = 1024, runs = 10;
+	const char* path = "loadbench.mesh";
+	const char* objPath = nullptr;
+	bool cold = false;
+	for (int i = 1; i < argc; ++i) {
+		#define arg(x) (!strcmp(argv[i], x))
+		if arg("--cold") { cold = true; continue; }
+		if (i + 1 >= argc) break;
+		if arg("--size") size = atoi(argv[i+1]);
+		else if arg("--runs") runs = atoi(argv[i+1]);
+		else if arg("--path") path = argv[i+1];
+		else if arg("--obj") objPath = argv[i+1];
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+		#undef arg
+		++i;
+	}
+
+	std::vector<float> vertices;
+	std::vector<int> indices;
+	for (int y = 0; y <= size; ++y)
+		for (int x = 0; x <= size; ++x)
+			vertices.insert(vertices.end(), {(float)x / size, (float)y / size,
+				0.f, (float)x / size, (float)y / size});
+	for (int y = 0; y < size; ++y)
+		for (int x = 0; x < size; ++x) {
+			int i = y * (size + 1) + x;
+			indices.insert(indices.end(),
+				{i, i + 1, i + size + 1, i + 1, i + size + 2, i + size + 1});
+		}
+	const auto& format = VertexFormat::compact();
+	if (!MeshFile::write(path, vertices, indices, format)) return -1;
+
+	auto context = HeadlessContext::create(64, 64);
+	if (!context) return -1;
+
+	double bytes = 0.;
+	std::vector<double> mapped, read, authored;
+	for (int run = 0; run < runs; ++run) {
+		if (cold) dropFromCache(path);
+		auto start = Clock::now();
+		{
+			auto file = MeshFile::open(path);
+			if (!file) return -1;
+			bytes = file.dataSize();
+			auto mesh = file.upload(MeshStorage::discard);
+			glFinish();
+			mapped.push_back(msSince(start));
+		}
+		finishRun();
+
+		if (cold) dropFromCache(path);
+		start = Clock::now();
+		{
+			FILE* file = fopen(path, "rb");
+			if (!file) return -1;
+			fseek(file, 0, SEEK_END);
+			std::vector<uint8_t> data(ftell(file));
+			fseek(file, 0, SEEK_SET);
+			size_t got = fread(data.data(), 1, data.size(), file);
+			fclose(file);
+			if (got != data.size()) return -1;
+			auto header = (const MeshFileHeader*)data.data();
+			auto mesh = Mesh::create(nullptr, &data[header->vertexOffset],
+				header->vertexCount, &data[header->indexOffset],
+				header->indexCount, header->indexType, format, header->decode,
+				MeshStorage::discard);
+			glFinish();
+			read.push_back(msSince(start));
+		}
+		finishRun();
+
+		start = Clock::now();
+		{
+			auto mesh = Mesh::create(std::vector<float>(vertices),
+				std::vector<int>(indices), format);
+			glFinish();
+			authored.push_back(msSince(start));
+		}
+		finishRun();
+	}
+
+	// OBJ import, with a private cache directory so the first load misses.
+	bool writeObj = !objPath;
+	std::string objFile = objPath ? objPath : std::string(path) + ".obj";
+	if (writeObj) {
+		FILE* file = fopen(objFile.c_str(), "w");
+		if (!file) return -1;
+		for (size_t v = 0; v < vertices.size(); v += 5)
+			fprintf(file, "v %g %g %g\nvt %g %g\n", vertices[v], vertices[v + 1],
+				vertices[v + 2], vertices[v + 3], vertices[v + 4]);
+		for (size_t i = 0; i < indices.size(); i += 3)
+			fprintf(file, "f %d/%d %d/%d %d/%d\n", indices[i] + 1,
+				indices[i] + 1, indices[i + 1] + 1, indices[i + 1] + 1,
+				indices[i + 2] + 1, indices[i + 2] + 1);
+		fclose(file);
+	}
+	std::string cacheDir = std::string(path) + ".cache";
+	std::filesystem::remove_all(cacheDir);
+	std::filesystem::create_directory(cacheDir);
+	double objBytes = 0.;
+	size_t objVertices = 0, objIndices = 0;
+	int threads = 0;
+	std::vector<double> serial, parallel, cached;
+	for (int run = 0; run < runs; ++run) {
+		if (cold) dropFromCache(objFile.c_str());
+		auto start = Clock::now();
+		auto imported = ImportedMesh::fromObj(objFile.c_str(), 1);
+		if (!imported) return -1;
+		serial.push_back(msSince(start));
+
+		if (cold) dropFromCache(objFile.c_str());
+		start = Clock::now();
+		imported = ImportedMesh::fromObj(objFile.c_str());
+		parallel.push_back(msSince(start));
+		objBytes = imported.stats.sourceBytes;
+		objVertices = imported.vertices.size() / 5;
+		objIndices = imported.indices.size();
+		threads = imported.stats.threads;
+
+		// the first run fills the cache.
+		start = Clock::now();
+		{
+			auto mesh = importMesh(objFile.c_str(), format,
+				MeshStorage::discard, cacheDir.c_str());
+			glFinish();
+			if (run > 0) cached.push_back(msSince(start));
+		}
+		finishRun();
+	}
+
+	auto print = [&](const char* name, std::vector<double> times,
+		double bytes, bool last) {
+		std::sort(times.begin(), times.end());
+		double best = times.empty() ? 0. : times.front(),
+			median = times.empty() ? 0. : times[times.size() / 2];
+		printf("\t\t\"%s\": {\"best_ms\": %.3f, \"median_ms\": %.3f, "
+			"\"mb_per_s\": %.1f}%s\n", name, best, median,
+			median > 0. ? bytes / (1 << 20) / (median / 1000.) : 0.,
+			last ? "" : ",");
+	};
+	printf("{\n\t\"renderer\": \"%s\",\n\t\"vertices\": %zu,\n"
+		"\t\"indices\": %zu,\n\t\"data_mb\": %.2f,\n\t\"runs\": %d,\n"
+		"\t\"cold\": %s,\n\t\"paths\": {\n",
+		(const char*)glGetString(GL_RENDERER), vertices.size() / 5,
+		indices.size(), bytes / (1 << 20), runs, cold ? "true" : "false");
+	print("mapped", mapped, bytes, false);
+	print("read", read, bytes, false);
+	print("authored", authored, bytes, true);
+	printf("\t},\n\t\"obj_import\": {\n\t\t\"source_mb\": %.2f,\n"
+		"\t\t\"vertices\": %zu,\n\t\t\"indices\": %zu,\n"
+		"\t\t\"threads\": %d,\n", objBytes / (1 << 20), objVertices,
+		objIndices, threads);
+	print("serial", serial, objBytes, false);
+	print("parallel", parallel, objBytes, false);
+	print("cached", cached, objBytes, true);
+	printf("\t}\n}\n");
+	context.destroy();
+	remove(path);
+	if (writeObj) remove(objFile.c_str());
+	std::filesystem::remove_all(cacheDir);
+	return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Unbounded multi-producer single-consumer queue (Vyukov's intrusive list).
+// push never blocks or fails, from any thread; pop is for one consumer
+// thread only. pop can briefly miss an item whose push is halfway done, it
+// shows up on a later pop.
+template <class T>
+struct MpscQueue {
+	MpscQueue() : head(&stub), tail(&stub) {}
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+	~MpscQueue() {
+		T value;
+		while (pop(value)) {}
+	}
+
+	void push(T value) {
+		auto node = new Node{std::move(value)};
+		Node* prev = head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	bool pop(T& value) {
+		Node* first = tail;
+		Node* next = first->next.load(std::memory_order_acquire);
+		if (first == &stub) {
+			if (!next) return false;
+			tail = first = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+		if (!next) {
+			if (first != head.load(std::memory_order_acquire)) return false;
+			// first is the last node, put the stub behind it so it can go.
+			stub.next.store(nullptr, std::memory_order_relaxed);
+			Node* prev = head.exchange(&stub, std::memory_order_acq_rel);
+			prev->next.store(&stub, std::memory_order_release);
+			next = first->next.load(std::memory_order_acquire);
+			if (!next) return false;
+		}
+		tail = next;
+		value = std::move(first->value);
+		delete first;
+		return true;
+	}
+
+private:
+	struct Node {
+		T value;
+		std::atomic<Node*> next{nullptr};
+	};
+	Node stub{};
+	std::atomic<Node*> head;
+	// consumer side only.
+	Node* tail;
+};
@@ -0,0 +1,106 @@
+#include "mappedfile.hpp"
+
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile MappedFile::open(const char* path) {
+	MappedFile out;
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		std::cout << "Failed to open " << path << '\n';
+		return out;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return out;
+	}
+	// the mapping keeps the file open by itself.
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+		nullptr);
+	CloseHandle(file);
+	if (!mapping) {
+		std::cout << "Failed to map " << path << '\n';
+		return out;
+	}
+	auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		std::cout << "Failed to map " << path << '\n';
+		CloseHandle(mapping);
+		return out;
+	}
+	out.data = (const uint8_t*)data;
+	out.size = size.QuadPart;
+	out.mapping = mapping;
+	return out;
+}
+
+void MappedFile::close() {
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	mapping = nullptr;
+	data = nullptr;
+	size = 0;
+}
+#else
+MappedFile MappedFile::open(const char* path) {
+	MappedFile out;
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		std::cout << "Failed to open " << path << '\n';
+		return out;
+	}
+	struct stat info;
+	if (fstat(fd, &info) < 0 || info.st_size == 0) {
+		::close(fd);
+		return out;
+	}
+	// the mapping stays valid after the descriptor is closed.
+	void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		std::cout << "Failed to map " << path << '\n';
+		return out;
+	}
+	madvise(data, info.st_size, MADV_SEQUENTIAL);
+	out.data = (const uint8_t*)data;
+	out.size = info.st_size;
+	return out;
+}
+
+void MappedFile::close() {
+	if (data) munmap((void*)data, size);
+	data = nullptr;
+	size = 0;
+}
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this == &other) return *this;
+	close();
+	data = std::exchange(other.data, nullptr);
+	size = std::exchange(other.size, 0);
+#ifdef _WIN32
+	mapping = std::exchange(other.mapping, nullptr);
+#endif
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
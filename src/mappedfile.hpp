@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A whole file mapped read-only into memory, unmapped on destruction.
+// Pages are read in by the OS on first touch, so nothing is copied until
+// the data is used, e.g. by glBufferSubData.
+struct MappedFile {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+	// an empty MappedFile if the file can't be opened or is empty.
+	static MappedFile open(const char* path);
+	operator bool() const { return data; }
+
+	MappedFile() = default;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+private:
+#ifdef _WIN32
+	void* mapping = nullptr;
+#endif
+	void close();
+};
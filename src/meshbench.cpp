@@ -0,0 +1,110 @@
+#include "meshopt.hpp"
+
+#include "glm.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Mesh optimization benchmark: runs optimizeMesh over procedural meshes in
+// authored and shuffled triangle order and prints ACMR/ATVR before and
+// after as JSON. Needs no GL.
+//
+// usage: meshbench [--size n] [--seed n]
+
+using Clock = std::chrono::steady_clock;
+
+struct TestMesh {
+	const char* name;
+	std::vector<float> vertices;
+	std::vector<int> indices;
+};
+
+// n x n quads in the xy plane, row by row, in the Mesh vertex format.
+static TestMesh grid(int n) {
+	TestMesh out{"grid", {}, {}};
+	for (int y = 0; y <= n; ++y)
+		for (int x = 0; x <= n; ++x)
+			out.vertices.insert(out.vertices.end(), {(float)x, (float)y, 0.f,
+				(float)x / n, (float)y / n});
+	for (int y = 0; y < n; ++y)
+		for (int x = 0; x < n; ++x) {
+			int i = y * (n + 1) + x;
+			out.indices.insert(out.indices.end(),
+				{i, i + 1, i + n + 1, i + 1, i + n + 2, i + n + 1});
+		}
+	return out;
+}
+
+// uv sphere with n rings and 2n segments.
+static TestMesh sphere(int n) {
+	TestMesh out{"sphere", {}, {}};
+	for (int ring = 0; ring <= n; ++ring)
+		for (int segment = 0; segment <= 2 * n; ++segment) {
+			float u = (float)segment / (2 * n), v = (float)ring / n;
+			float theta = u * glm::two_pi<float>(), phi = v * glm::pi<float>();
+			out.vertices.insert(out.vertices.end(), {
+				glm::sin(phi) * glm::cos(theta), glm::cos(phi),
+				glm::sin(phi) * glm::sin(theta), u, v});
+		}
+	for (int ring = 0; ring < n; ++ring)
+		for (int segment = 0; segment < 2 * n; ++segment) {
+			int i = ring * (2 * n + 1) + segment, below = i + 2 * n + 1;
+			out.indices.insert(out.indices.end(),
+				{i, below, i + 1, i + 1, below, below + 1});
+		}
+	return out;
+}
+
+static TestMesh shuffled(TestMesh mesh, std::mt19937& rng) {
+	size_t triangles = mesh.indices.size() / 3;
+	for (size_t i = triangles - 1; i > 0; --i) {
+		size_t j = std::uniform_int_distribution<size_t>(0, i)(rng);
+		for (int k = 0; k < 3; ++k)
+			std::swap(mesh.indices[i * 3 + k], mesh.indices[j * 3 + k]);
+	}
+	return mesh;
+}
+
+int main(int argc, char** argv) {
+	int size = 256;
+	unsigned seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		#define arg(x) (!strcmp(argv[i], x))
+		if arg("--size") size = atoi(argv[i+1]);
+		else if arg("--seed") seed = atoi(argv[i+1]);
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+		#undef arg
+	}
+
+	std::mt19937 rng(seed);
+	std::vector<std::pair<const char*, TestMesh>> meshes = {
+		{"authored", grid(size)},
+		{"shuffled", shuffled(grid(size), rng)},
+		{"authored", sphere(size)},
+		{"shuffled", shuffled(sphere(size), rng)},
+	};
+	printf("{\n\t\"cache_size\": 16,\n\t\"meshes\": [\n");
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		auto& [order, mesh] = meshes[i];
+		size_t triangles = mesh.indices.size() / 3;
+		auto start = Clock::now();
+		auto report = optimizeMesh(mesh.vertices, mesh.indices, 5);
+		double ms = std::chrono::duration<double, std::milli>(
+			Clock::now() - start).count();
+		printf("%s\t\t{\"mesh\": \"%s\", \"order\": \"%s\", \"triangles\": %zu, "
+			"\"clusters\": %zu, \"ms\": %.3f,\n\t\t\t\"acmr\": {\"before\": %.3f, "
+			"\"after\": %.3f}, \"atvr\": {\"before\": %.3f, \"after\": %.3f}}",
+			i ? ",\n" : "", mesh.name, order, triangles, report.clusters, ms,
+			report.before.acmr, report.after.acmr, report.before.atvr,
+			report.after.atvr);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
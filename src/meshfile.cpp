@@ -0,0 +1,145 @@
+#include "meshfile.hpp"
+#include "renderer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static uint64_t alignBlob(uint64_t offset) {
+	return (offset + MeshFile::blobAlignment - 1)
+		& ~(MeshFile::blobAlignment - 1);
+}
+
+MeshFile MeshFile::open(const char* path) {
+	MeshFile out;
+	auto file = std::make_shared<MappedFile>(MappedFile::open(path));
+	if (!*file) return out;
+	auto fail = [&](const char* reason) {
+		std::cout << path << " is not a valid mesh file: " << reason << '\n';
+		return MeshFile{};
+	};
+	if (file->size < sizeof(MeshFileHeader)) return fail("truncated header");
+	auto header = (const MeshFileHeader*)file->data;
+	if (header->tag != MeshFileHeader::magic) return fail("bad magic");
+	if (header->version != MeshFileHeader::currentVersion)
+		return fail("unsupported version");
+	if (header->attribCount == 0 || header->attribCount > 16)
+		return fail("bad attribute count");
+	if (header->indexType != GL_UNSIGNED_SHORT
+		&& header->indexType != GL_UNSIGNED_INT)
+		return fail("bad index type");
+	size_t attribsEnd = sizeof(MeshFileHeader)
+		+ header->attribCount * sizeof(MeshFileAttrib);
+	if (file->size < attribsEnd) return fail("truncated attributes");
+
+	std::vector<VertexAttrib> attribs;
+	auto fileAttribs = (const MeshFileAttrib*)(header + 1);
+	for (uint32_t a = 0; a < header->attribCount; ++a) {
+		auto& attrib = fileAttribs[a];
+		if (attrib.type > (uint32_t)AttribType::snorm10
+			|| attrib.components == 0 || attrib.components > 4)
+			return fail("bad attribute");
+		attribs.push_back({attrib.location, (GLint)attrib.components,
+			(AttribType)attrib.type});
+	}
+	out.format = VertexFormat::create(attribs);
+	if ((uint32_t)out.format.stride != header->stride)
+		return fail("stride doesn't match the attributes");
+
+	uint64_t vertexBytes = (uint64_t)header->vertexCount * header->stride,
+		indexBytes = (uint64_t)header->indexCount
+			* IndexData::size(header->indexType);
+	if (header->vertexOffset % blobAlignment
+		|| header->indexOffset % blobAlignment)
+		return fail("misaligned data");
+	// offset + bytes could wrap around.
+	if (header->vertexOffset < attribsEnd
+		|| header->vertexOffset > file->size
+		|| vertexBytes > file->size - header->vertexOffset
+		|| header->indexOffset < attribsEnd
+		|| header->indexOffset > file->size
+		|| indexBytes > file->size - header->indexOffset)
+		return fail("data out of bounds");
+
+	out.header = header;
+	out.vertices = file->data + header->vertexOffset;
+	out.indices = file->data + header->indexOffset;
+	out.bounds = {header->boundsMin, header->boundsMax};
+	out.file = std::move(file);
+	return out;
+}
+
+size_t MeshFile::dataSize() const {
+	if (!header) return 0;
+	return (size_t)header->vertexCount * header->stride
+		+ (size_t)header->indexCount * IndexData::size(header->indexType);
+}
+
+Mesh MeshFile::upload(MeshStorage storage) const {
+	if (!header) return {};
+	return Mesh::create(file, vertices, header->vertexCount, indices,
+		header->indexCount, header->indexType, format, header->decode,
+		storage);
+}
+
+bool MeshFile::write(const char* path, const std::vector<float>& vertices,
+	const std::vector<int>& indices, const VertexFormat& format) {
+	size_t vertexCount = vertices.size() / format.sourceStride;
+	MeshFileHeader header{};
+	header.tag = MeshFileHeader::magic;
+	header.version = MeshFileHeader::currentVersion;
+	header.attribCount = format.attribs.size();
+	header.stride = format.stride;
+	header.vertexCount = vertexCount;
+	header.indexCount = indices.size();
+
+	Aabb bounds;
+	for (size_t v = 0; v < vertexCount; ++v)
+		bounds.grow(glm::make_vec3(&vertices[v * format.sourceStride]));
+	header.boundsMin = bounds.min;
+	header.boundsMax = bounds.max;
+	header.decode = glm::mat4(1.f);
+	std::vector<uint8_t> packed;
+	if (format.normalized()) {
+		auto normalized = vertices;
+		// same as Mesh::create, around the shader offset.
+		header.decode = glm::translate(glm::mat4(1.f), shaderOffset)
+			* normalizePositions(normalized, format.sourceStride)
+			* glm::translate(glm::mat4(1.f), -shaderOffset);
+		packed = format.encode(normalized);
+	} else {
+		packed = format.encode(vertices);
+	}
+	auto packedIndices = IndexData::pack(indices, vertexCount);
+	header.indexType = packedIndices.type;
+
+	std::vector<MeshFileAttrib> attribs;
+	for (auto& attrib : format.attribs)
+		attribs.push_back({attrib.location, (uint32_t)attrib.components,
+			(uint32_t)attrib.type});
+	header.vertexOffset = alignBlob(sizeof(MeshFileHeader)
+		+ attribs.size() * sizeof(MeshFileAttrib));
+	header.indexOffset = alignBlob(header.vertexOffset + packed.size());
+
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		std::cout << "Failed to open " << path << '\n';
+		return false;
+	}
+	const uint8_t zeros[blobAlignment] = {};
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(attribs.data(), sizeof(MeshFileAttrib), attribs.size(), file)
+			== attribs.size();
+	auto pad = [&](uint64_t to) {
+		long at = ftell(file);
+		return at >= 0 && fwrite(zeros, 1, to - at, file) == to - at;
+	};
+	ok = ok && pad(header.vertexOffset)
+		&& fwrite(packed.data(), 1, packed.size(), file) == packed.size()
+		&& pad(header.indexOffset)
+		&& fwrite(packedIndices.bytes.data(), 1, packedIndices.bytes.size(),
+			file) == packedIndices.bytes.size();
+	if (fclose(file) != 0) ok = false;
+	if (!ok) std::cout << "Failed to write " << path << '\n';
+	return ok;
+}
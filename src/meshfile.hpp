@@ -0,0 +1,77 @@
+#pragma once
+
+#include "bvh.hpp"
+#include "glm.hpp"
+#include "mappedfile.hpp"
+#include "vertexformat.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct Mesh;
+enum class MeshStorage : uint8_t;
+
+// Binary mesh container, laid out so the file can be mapped and its blobs
+// handed to GL as they are:
+//
+//	MeshFileHeader
+//	MeshFileAttrib[attribCount]
+//	vertices, packed in the stored format, at vertexOffset
+//	indices, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, at indexOffset
+//
+// Both blobs start on a blobAlignment boundary. Everything is little
+// endian, which is all the renderer runs on.
+struct MeshFileHeader {
+	static constexpr uint32_t magic = 0x4853454d; // "MESH"
+	static constexpr uint32_t currentVersion = 1;
+	uint32_t tag, version;
+	uint32_t attribCount;
+	// bytes per vertex, has to match the attributes.
+	uint32_t stride;
+	uint32_t vertexCount, indexCount;
+	uint32_t indexType;
+	uint32_t _pad;
+	uint64_t vertexOffset, indexOffset;
+	// authored positions, before any normalization.
+	glm::vec3 boundsMin, boundsMax;
+	uint32_t _pad2[2];
+	// see Mesh::decode.
+	glm::mat4 decode;
+};
+static_assert(offsetof(MeshFileHeader, vertexOffset) == 32);
+static_assert(offsetof(MeshFileHeader, decode) == 80);
+static_assert(sizeof(MeshFileHeader) == 144);
+
+struct MeshFileAttrib {
+	uint32_t location;
+	uint32_t components;
+	uint32_t type;
+};
+
+struct MeshFile {
+	static constexpr uint64_t blobAlignment = 64;
+	// shared with every Mesh uploaded with MeshStorage::mapped.
+	std::shared_ptr<const MappedFile> file;
+	const MeshFileHeader* header = nullptr;
+	VertexFormat format;
+	const uint8_t* vertices = nullptr;
+	const uint8_t* indices = nullptr;
+	Aabb bounds;
+
+	// maps path and checks the header, nothing else is read. an empty
+	// MeshFile if it isn't a valid mesh file.
+	static MeshFile open(const char* path);
+	operator bool() const { return header; }
+	// vertexCount * stride plus the index bytes.
+	size_t dataSize() const;
+	Mesh upload(MeshStorage storage) const;
+
+	// packs authored vertices (format.sourceStride floats each) and
+	// indices into a mesh file at path.
+	static bool write(const char* path, const std::vector<float>& vertices,
+		const std::vector<int>& indices, const VertexFormat& format);
+};
@@ -0,0 +1,216 @@
+#include "meshopt.hpp"
+
+#include "glm.hpp"
+
+#include <algorithm>
+
+CacheStats CacheStats::analyze(const std::vector<int>& indices,
+	size_t vertexCount, int cacheSize) {
+	// a vertex is in the FIFO while fewer than cacheSize misses happened
+	// since it was last loaded.
+	std::vector<int64_t> loadedAt(vertexCount, INT64_MIN / 2);
+	std::vector<bool> used(vertexCount);
+	int64_t misses = 0;
+	size_t unique = 0;
+	for (int index : indices) {
+		if (misses - loadedAt[index] >= cacheSize) loadedAt[index] = misses++;
+		if (!used[index]) {
+			used[index] = true;
+			unique++;
+		}
+	}
+	CacheStats out{};
+	size_t triangles = indices.size() / 3;
+	out.acmr = triangles ? (float)misses / triangles : 0.f;
+	out.atvr = unique ? (float)misses / unique : 0.f;
+	return out;
+}
+
+void optimizeVertexCache(std::vector<int>& indices, size_t vertexCount,
+	std::vector<uint32_t>* clusters, int cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	if (!triangleCount) return;
+
+	// triangles around each vertex, as offsets into one array.
+	std::vector<uint32_t> live(vertexCount), offsets(vertexCount + 1),
+		adjacency(triangleCount * 3);
+	for (int index : indices) live[index]++;
+	for (size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	std::vector<int> cacheTime(vertexCount), deadEnd, out;
+	std::vector<bool> emitted(triangleCount);
+	std::vector<int> candidates;
+	out.reserve(indices.size());
+	int time = cacheSize + 1;
+	size_t cursor = 0;
+	int fan = 0;
+	if (clusters) clusters->push_back(0);
+	while (fan >= 0) {
+		candidates.clear();
+		for (uint32_t i = offsets[fan]; i < offsets[fan + 1]; ++i) {
+			uint32_t t = adjacency[i];
+			if (emitted[t]) continue;
+			emitted[t] = true;
+			for (int k = 0; k < 3; ++k) {
+				int v = indices[t * 3 + k];
+				out.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cacheTime[v] > cacheSize) cacheTime[v] = time++;
+			}
+		}
+
+		// the candidate that will still be cached after emitting all its
+		// live triangles, oldest first; otherwise fall back to a dead end.
+		int best = -1, bestPriority = -1;
+		for (int v : candidates) {
+			if (!live[v]) continue;
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * (int)live[v] <= cacheSize)
+				priority = time - cacheTime[v];
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = v;
+			}
+		}
+		if (best < 0) {
+			while (!deadEnd.empty() && best < 0) {
+				int v = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[v]) best = v;
+			}
+			while (best < 0 && cursor < vertexCount) {
+				if (live[cursor]) best = cursor;
+				cursor++;
+			}
+			if (best >= 0 && clusters && out.size() / 3 < triangleCount)
+				clusters->push_back(out.size() / 3);
+		}
+		fan = best;
+	}
+	indices = std::move(out);
+}
+
+size_t optimizeOverdraw(std::vector<int>& indices,
+	const std::vector<float>& vertices, size_t stride,
+	std::vector<uint32_t> clusters, float threshold, int cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	if (!triangleCount || stride < 3) return 0;
+	if (clusters.empty() || clusters[0] != 0) clusters.insert(clusters.begin(), 0);
+	clusters.push_back(triangleCount);
+
+	// soft boundaries: restart the cache simulation at every cluster and
+	// cut once its running ACMR is within threshold of the whole input's.
+	// the simulation is reset by advancing the clock past every entry.
+	float limit = CacheStats::analyze(indices, vertices.size() / stride,
+		cacheSize).acmr * threshold;
+	std::vector<uint32_t> split;
+	std::vector<int64_t> loadedAt(vertices.size() / stride, INT64_MIN / 2);
+	int64_t clock = 0;
+	for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+		split.push_back(clusters[c]);
+		clock += cacheSize;
+		uint32_t start = clusters[c], misses = 0;
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+			for (int k = 0; k < 3; ++k) {
+				int v = indices[t * 3 + k];
+				if (clock - loadedAt[v] >= cacheSize) {
+					loadedAt[v] = clock++;
+					misses++;
+				}
+			}
+			uint32_t count = t + 1 - start;
+			if (t + 1 < clusters[c + 1] && count > 1
+				&& (float)misses / count <= limit) {
+				split.push_back(t + 1);
+				clock += cacheSize;
+				misses = 0;
+				start = t + 1;
+			}
+		}
+	}
+	split.push_back(triangleCount);
+
+	auto position = [&](int index) {
+		auto p = &vertices[index * stride];
+		return glm::vec3(p[0], p[1], p[2]);
+	};
+	// area weighted centroid and normal of each cluster.
+	struct Cluster {
+		uint32_t first, last;
+		float sortKey;
+	};
+	std::vector<Cluster> sorted;
+	glm::vec3 meshCenter(0.f);
+	float meshArea = 0.f;
+	std::vector<glm::vec3> centers, normals;
+	for (size_t c = 0; c + 1 < split.size(); ++c) {
+		glm::vec3 center(0.f), normal(0.f);
+		float area = 0.f;
+		for (uint32_t t = split[c]; t < split[c + 1]; ++t) {
+			auto a = position(indices[t * 3]), b = position(indices[t * 3 + 1]),
+				d = position(indices[t * 3 + 2]);
+			auto n = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(n) * .5f;
+			center += (a + b + d) / 3.f * triangleArea;
+			normal += n;
+			area += triangleArea;
+		}
+		meshCenter += center;
+		meshArea += area;
+		centers.push_back(area > 0.f ? center / area : center);
+		normals.push_back(glm::length(normal) > 0.f ? glm::normalize(normal)
+			: normal);
+		sorted.push_back({split[c], split[c + 1], 0.f});
+	}
+	if (meshArea > 0.f) meshCenter /= meshArea;
+	for (size_t c = 0; c < sorted.size(); ++c)
+		sorted[c].sortKey = glm::dot(centers[c] - meshCenter, normals[c]);
+	std::stable_sort(sorted.begin(), sorted.end(),
+		[](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<int> out;
+	out.reserve(indices.size());
+	for (auto& cluster : sorted)
+		out.insert(out.end(), indices.begin() + cluster.first * 3,
+			indices.begin() + cluster.last * 3);
+	indices = std::move(out);
+	return sorted.size();
+}
+
+size_t optimizeVertexFetch(std::vector<float>& vertices, size_t stride,
+	std::vector<int>& indices) {
+	std::vector<int> remap(vertices.size() / stride, -1);
+	std::vector<float> out;
+	out.reserve(vertices.size());
+	int next = 0;
+	for (int& index : indices) {
+		if (remap[index] < 0) {
+			remap[index] = next++;
+			out.insert(out.end(), vertices.begin() + index * stride,
+				vertices.begin() + (index + 1) * stride);
+		}
+		index = remap[index];
+	}
+	vertices = std::move(out);
+	return next;
+}
+
+MeshOptimizeReport optimizeMesh(std::vector<float>& vertices,
+	std::vector<int>& indices, size_t stride) {
+	MeshOptimizeReport out{};
+	size_t vertexCount = vertices.size() / stride;
+	out.before = CacheStats::analyze(indices, vertexCount);
+	std::vector<uint32_t> clusters;
+	optimizeVertexCache(indices, vertexCount, &clusters);
+	out.clusters = optimizeOverdraw(indices, vertices, stride,
+		std::move(clusters));
+	vertexCount = optimizeVertexFetch(vertices, stride, indices);
+	out.after = CacheStats::analyze(indices, vertexCount);
+	return out;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Index and vertex reordering for meshes in the Mesh layout: interleaved
+// floats with the position first, int triangle lists. Meant to run once
+// when a mesh is loaded or cooked, none of it touches GL.
+
+// post-transform cache efficiency, simulated with a FIFO of cacheSize
+// vertices. acmr is vertex shader invocations per triangle (0.5 at best on
+// a regular grid, 3 at worst), atvr per referenced vertex (1 at best).
+struct CacheStats {
+	float acmr, atvr;
+	static CacheStats analyze(const std::vector<int>& indices,
+		size_t vertexCount, int cacheSize = 16);
+};
+
+// Tipsify (Sander et al. 2007): reorders triangles to fan around recently
+// used vertices. appends to clusters the first triangle of each run that
+// had to restart from a dead end; those runs can be reordered freely
+// without hurting the cache much.
+void optimizeVertexCache(std::vector<int>& indices, size_t vertexCount,
+	std::vector<uint32_t>* clusters = nullptr, int cacheSize = 16);
+
+// sorts the clusters found by optimizeVertexCache so the ones facing away
+// from the mesh center come first, which lets early z reject more of what
+// follows. clusters are split further wherever a run's ACMR gets within
+// threshold times the input's, so the cache efficiency degrades by about
+// that factor at most. returns the number of clusters after splitting.
+size_t optimizeOverdraw(std::vector<int>& indices,
+	const std::vector<float>& vertices, size_t stride,
+	std::vector<uint32_t> clusters, float threshold = 1.05f,
+	int cacheSize = 16);
+
+// renumbers vertices in the order the indices first use them and drops
+// unreferenced ones, so fetches walk the vertex buffer forward.
+// returns the new vertex count.
+size_t optimizeVertexFetch(std::vector<float>& vertices, size_t stride,
+	std::vector<int>& indices);
+
+struct MeshOptimizeReport {
+	CacheStats before, after;
+	// as ordered by optimizeOverdraw.
+	size_t clusters;
+};
+
+// runs all three passes, stride in floats.
+MeshOptimizeReport optimizeMesh(std::vector<float>& vertices,
+	std::vector<int>& indices, size_t stride);
@@ -0,0 +1,277 @@
+#include "occlusion.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+
+// Workers sleep between frames; run() wakes them, hands out job indices
+// through an atomic counter, helps out on the calling thread and returns
+// once every index is done.
+struct OcclusionBuffer::Pool {
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	std::function<void(int)> job;
+	std::atomic<int> next{0};
+	int count = 0, busy = 0;
+	unsigned generation = 0;
+	bool quit = false;
+
+	Pool(int workers) {
+		for (int i = 0; i < workers; ++i)
+			threads.emplace_back([this] { loop(); });
+	}
+
+	~Pool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (auto& thread : threads) thread.join();
+	}
+
+	void work() {
+		for (int i; (i = next++) < count;) job(i);
+	}
+
+	void loop() {
+		unsigned seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return quit || generation != seen; });
+				if (quit) return;
+				seen = generation;
+			}
+			work();
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0) done.notify_one();
+		}
+	}
+
+	void run(int jobs, std::function<void(int)> fn) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = std::move(fn);
+			count = jobs;
+			next = 0;
+			busy = threads.size();
+			generation++;
+		}
+		wake.notify_all();
+		work();
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return busy == 0; });
+	}
+};
+
+OcclusionBuffer::OcclusionBuffer() = default;
+OcclusionBuffer::OcclusionBuffer(OcclusionBuffer&&) = default;
+OcclusionBuffer& OcclusionBuffer::operator=(OcclusionBuffer&&) = default;
+OcclusionBuffer::~OcclusionBuffer() = default;
+
+OcclusionBuffer OcclusionBuffer::create(int width, int height, int threads) {
+	OcclusionBuffer out;
+	out.width = width & ~3;
+	out.height = height / bandHeight * bandHeight;
+	out.depth.assign(out.width * out.height, 1.f);
+	// odd sizes round up, the last texel of a row or column covers one
+	// pixel less.
+	for (int w = out.width, h = out.height; w > 1 || h > 1;) {
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+		out.hiZ.emplace_back(w * h, 1.f);
+	}
+	out.bins.resize(out.height / bandHeight);
+	if (threads <= 0) threads = std::thread::hardware_concurrency();
+	threads = std::min<int>(threads, out.bins.size());
+	out.pool = std::make_unique<Pool>(std::max(threads - 1, 0));
+	return out;
+}
+
+void OcclusionBuffer::begin(const glm::mat4& viewProjection) {
+	this->viewProjection = viewProjection;
+	for (auto& bin : bins) bin.clear();
+	std::fill(depth.begin(), depth.end(), 1.f);
+	stats = {};
+}
+
+void OcclusionBuffer::addOccluder(const float* vertices, size_t stride,
+	const int* indices, size_t indexCount, const glm::mat4& model) {
+	auto transform = viewProjection * model;
+	auto size = glm::vec2(width, height);
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+		glm::vec3 screen[3];
+		bool clipped = false;
+		for (int k = 0; k < 3; ++k) {
+			auto p = (const float*)((const char*)vertices
+				+ indices[i + k] * stride);
+			auto clip = transform * glm::vec4(p[0], p[1], p[2], 1.f);
+			if (clip.w <= 0.f || clip.z < -clip.w) {
+				clipped = true;
+				break;
+			}
+			auto ndc = glm::vec3(clip) / clip.w;
+			screen[k] = glm::vec3((glm::vec2(ndc) * .5f + .5f) * size,
+				ndc.z * .5f + .5f);
+		}
+		if (clipped) continue;
+
+		// counter clockwise, so inside means every edge function >= 0.
+		auto e1 = screen[1] - screen[0], e2 = screen[2] - screen[0];
+		float area = e1.x * e2.y - e1.y * e2.x;
+		if (area == 0.f) continue;
+		if (area < 0.f) {
+			std::swap(screen[1], screen[2]);
+			std::swap(e1, e2);
+			area = -area;
+		}
+
+		Triangle t;
+		for (int k = 0; k < 3; ++k) t.v[k] = glm::vec2(screen[k]);
+		// depth plane through the three vertices.
+		t.a = (e1.z * e2.y - e2.z * e1.y) / area;
+		t.b = (e2.z * e1.x - e1.z * e2.x) / area;
+		t.c = screen[0].z - t.a * screen[0].x - t.b * screen[0].y;
+		auto lo = glm::min(glm::min(t.v[0], t.v[1]), t.v[2]);
+		auto hi = glm::max(glm::max(t.v[0], t.v[1]), t.v[2]);
+		t.minX = std::max(0, (int)glm::floor(lo.x));
+		t.minY = std::max(0, (int)glm::floor(lo.y));
+		t.maxX = std::min(width - 1, (int)glm::ceil(hi.x));
+		t.maxY = std::min(height - 1, (int)glm::ceil(hi.y));
+		if (t.minX > t.maxX || t.minY > t.maxY) continue;
+		for (int band = t.minY / bandHeight; band <= t.maxY / bandHeight; ++band)
+			bins[band].push_back(t);
+		stats.triangles++;
+	}
+}
+
+void OcclusionBuffer::rasterize() {
+	pool->run(bins.size(), [this](int band) { rasterizeBand(band); });
+	buildHiZ();
+}
+
+// Half-space rasterization: for each edge v[i] -> v[j] the function
+// A*x + B*y + C is >= 0 on the inner side, and steps by A along a row.
+void OcclusionBuffer::rasterizeBand(int band) {
+	int bandMin = band * bandHeight, bandMax = bandMin + bandHeight - 1;
+	for (auto& t : bins[band]) {
+		float A[3], B[3], C[3];
+		for (int i = 0; i < 3; ++i) {
+			auto& p = t.v[i];
+			auto& q = t.v[(i + 1) % 3];
+			A[i] = p.y - q.y;
+			B[i] = q.x - p.x;
+			C[i] = -(A[i] * p.x + B[i] * p.y);
+		}
+		int x0 = t.minX & ~3;
+		int y0 = std::max(t.minY, bandMin), y1 = std::min(t.maxY, bandMax);
+		for (int y = y0; y <= y1; ++y) {
+			float py = y + .5f;
+			float* row = &depth[y * width];
+#ifdef __SSE2__
+			__m128 px = _mm_add_ps(_mm_set1_ps(x0 + .5f),
+				_mm_set_ps(3.f, 2.f, 1.f, 0.f));
+			__m128 e[3], step[3];
+			for (int i = 0; i < 3; ++i) {
+				e[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[i]), px),
+					_mm_set1_ps(B[i] * py + C[i]));
+				step[i] = _mm_set1_ps(A[i] * 4.f);
+			}
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.a), px),
+				_mm_set1_ps(t.b * py + t.c));
+			__m128 zStep = _mm_set1_ps(t.a * 4.f);
+			for (int x = x0; x <= t.maxX; x += 4) {
+				__m128 inside = _mm_and_ps(_mm_cmpge_ps(e[0], _mm_setzero_ps()),
+					_mm_and_ps(_mm_cmpge_ps(e[1], _mm_setzero_ps()),
+						_mm_cmpge_ps(e[2], _mm_setzero_ps())));
+				if (_mm_movemask_ps(inside)) {
+					__m128 old = _mm_loadu_ps(row + x);
+					__m128 nearer = _mm_min_ps(old, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer),
+						_mm_andnot_ps(inside, old)));
+				}
+				for (int i = 0; i < 3; ++i) e[i] = _mm_add_ps(e[i], step[i]);
+				z = _mm_add_ps(z, zStep);
+			}
+#else
+			for (int x = x0; x <= t.maxX; ++x) {
+				float px = x + .5f;
+				bool inside = true;
+				for (int i = 0; i < 3; ++i)
+					inside &= A[i] * px + B[i] * py + C[i] >= 0.f;
+				if (inside)
+					row[x] = std::min(row[x], t.a * px + t.b * py + t.c);
+			}
+#endif
+		}
+	}
+}
+
+void OcclusionBuffer::buildHiZ() {
+	const float* src = depth.data();
+	int srcW = width, srcH = height;
+	for (auto& level : hiZ) {
+		int w = (srcW + 1) / 2, h = (srcH + 1) / 2;
+		for (int y = 0; y < h; ++y) {
+			int y0 = y * 2, y1 = std::min(y0 + 1, srcH - 1);
+			for (int x = 0; x < w; ++x) {
+				int x0 = x * 2, x1 = std::min(x0 + 1, srcW - 1);
+				level[y * w + x] = std::max(
+					std::max(src[y0 * srcW + x0], src[y0 * srcW + x1]),
+					std::max(src[y1 * srcW + x0], src[y1 * srcW + x1]));
+			}
+		}
+		src = level.data();
+		srcW = w;
+		srcH = h;
+	}
+}
+
+bool OcclusionBuffer::visible(const Aabb& box) {
+	stats.tested++;
+	if (hiZ.empty()) return true;
+	glm::vec2 lo(INFINITY), hi(-INFINITY);
+	float nearest = INFINITY;
+	for (int i = 0; i < 8; ++i) {
+		auto corner = glm::vec3(i & 1 ? box.max.x : box.min.x,
+			i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z);
+		auto clip = viewProjection * glm::vec4(corner, 1.f);
+		// reaches in front of the near plane, can't be hidden.
+		if (clip.w <= 0.f || clip.z < -clip.w) return true;
+		auto ndc = glm::vec3(clip) / clip.w;
+		auto screen = (glm::vec2(ndc) * .5f + .5f) * glm::vec2(width, height);
+		lo = glm::min(lo, screen);
+		hi = glm::max(hi, screen);
+		nearest = std::min(nearest, ndc.z * .5f + .5f);
+	}
+	int x0 = std::max(0, (int)glm::floor(lo.x));
+	int y0 = std::max(0, (int)glm::floor(lo.y));
+	int x1 = std::min(width - 1, (int)glm::ceil(hi.x));
+	int y1 = std::min(height - 1, (int)glm::ceil(hi.y));
+	if (x0 > x1 || y0 > y1) return true;
+
+	// finest level where the rectangle covers about 4x4 texels or less,
+	// a level i texel covering 2^(i+1) pixels per axis.
+	int level = 0;
+	while (level + 1 < (int)hiZ.size()
+		&& (std::max(x1 - x0, y1 - y0) >> (level + 1)) >= 4)
+		++level;
+	int shift = level + 1;
+	int round = (1 << shift) - 1;
+	int w = (width + round) >> shift, h = (height + round) >> shift;
+	auto& texels = hiZ[level];
+	for (int y = y0 >> shift; y <= std::min(y1 >> shift, h - 1); ++y)
+		for (int x = x0 >> shift; x <= std::min(x1 >> shift, w - 1); ++x)
+			if (nearest <= texels[y * w + x]) return true;
+	stats.occluded++;
+	return false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "bvh.hpp"
+#include "glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Low resolution software depth buffer for occlusion culling on the cpu.
+// Large occluders are rasterized into it each frame, a max-depth pyramid is
+// built over the result, and object boxes are tested against the pyramid
+// before they're submitted. Nothing is read back from the gpu.
+//
+// Depth is z/w in [0, 1], 1 being the far plane. The screen is cut into
+// bands of bandHeight rows; triangles are binned per band when added and
+// the bands are rasterized by a small pool of worker threads.
+struct OcclusionBuffer {
+	static const int bandHeight = 16;
+
+	struct Stats {
+		int triangles, tested, occluded;
+	};
+
+	int width = 0, height = 0;
+	// one level per halving, level 0 holds the max depth of each 2x2 pixel
+	// block of depth.
+	std::vector<std::vector<float>> hiZ;
+	std::vector<float> depth;
+	Stats stats{};
+
+	// width must be a multiple of 4 and height of bandHeight. threads
+	// includes the calling one, 0 picks one per hardware thread.
+	static OcclusionBuffer create(int width = 256, int height = 128,
+		int threads = 0);
+
+	// resets depth to the far plane and drops last frame's occluders.
+	void begin(const glm::mat4& viewProjection);
+	// bins the triangles of an indexed mesh, positions being the first
+	// three floats of each vertex. triangles crossing the near plane are
+	// skipped, which only makes the buffer more conservative.
+	void addOccluder(const float* vertices, size_t stride, const int* indices,
+		size_t indexCount, const glm::mat4& model);
+	// rasterizes all bins and builds the pyramid.
+	void rasterize();
+	// false if the box is certainly hidden behind the occluders.
+	bool visible(const Aabb& box);
+
+	OcclusionBuffer();
+	OcclusionBuffer(OcclusionBuffer&&);
+	OcclusionBuffer& operator=(OcclusionBuffer&&);
+	~OcclusionBuffer();
+
+private:
+	// screen space triangle set up for the edge function walk.
+	struct Triangle {
+		glm::vec2 v[3];
+		// depth plane: z = a*x + b*y + c.
+		float a, b, c;
+		int minX, minY, maxX, maxY;
+	};
+	struct Pool;
+
+	glm::mat4 viewProjection;
+	std::vector<std::vector<Triangle>> bins;
+	std::unique_ptr<Pool> pool;
+
+	void rasterizeBand(int band);
+	void buildHiZ();
+};
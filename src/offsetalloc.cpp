@@ -0,0 +1,155 @@
+#include "offsetalloc.hpp"
+
+#include <algorithm>
+
+static uint32_t highestBit(uint32_t x) {
+	return 31 - __builtin_clz(x);
+}
+
+// bin whose sizes are all <= size.
+static uint32_t binRoundDown(uint32_t size) {
+	if (size < 8) return size;
+	uint32_t exponent = highestBit(size) - 3;
+	return (exponent + 1) << 3 | ((size >> exponent) & 7);
+}
+
+static uint32_t binSize(uint32_t bin) {
+	if (bin < 8) return bin;
+	return (8 | (bin & 7)) << ((bin >> 3) - 1);
+}
+
+// first bin whose sizes are all >= size.
+static uint32_t binRoundUp(uint32_t size) {
+	uint32_t bin = binRoundDown(size);
+	return binSize(bin) < size ? bin + 1 : bin;
+}
+
+OffsetAllocator OffsetAllocator::create(uint32_t size) {
+	OffsetAllocator out;
+	std::fill(std::begin(out.bins), std::end(out.bins), none);
+	out.size = size;
+	out.freeSpace = size;
+	if (size) out.insert(out.newNode(0, size));
+	return out;
+}
+
+uint32_t OffsetAllocator::newNode(uint32_t offset, uint32_t size) {
+	uint32_t index;
+	if (!unusedNodes.empty()) {
+		index = unusedNodes.back();
+		unusedNodes.pop_back();
+		nodes[index] = Node{};
+	} else {
+		index = nodes.size();
+		nodes.emplace_back();
+	}
+	nodes[index].offset = offset;
+	nodes[index].size = size;
+	return index;
+}
+
+void OffsetAllocator::insert(uint32_t index) {
+	auto& node = nodes[index];
+	uint32_t bin = binRoundDown(node.size);
+	node.binPrev = none;
+	node.binNext = bins[bin];
+	if (node.binNext != none) nodes[node.binNext].binPrev = index;
+	bins[bin] = index;
+	binMasks[bin >> 3] |= 1 << (bin & 7);
+	groupMask |= 1u << (bin >> 3);
+}
+
+void OffsetAllocator::remove(uint32_t index) {
+	auto& node = nodes[index];
+	uint32_t bin = binRoundDown(node.size);
+	if (node.binPrev != none) nodes[node.binPrev].binNext = node.binNext;
+	else bins[bin] = node.binNext;
+	if (node.binNext != none) nodes[node.binNext].binPrev = node.binPrev;
+	if (bins[bin] == none) {
+		binMasks[bin >> 3] &= ~(1 << (bin & 7));
+		if (!binMasks[bin >> 3]) groupMask &= ~(1u << (bin >> 3));
+	}
+}
+
+uint32_t OffsetAllocator::findBin(uint32_t bin) const {
+	if (bin >= binCount) return none;
+	uint32_t group = bin >> 3;
+	uint32_t inGroup = binMasks[group] & (0xFFu << (bin & 7));
+	if (inGroup) return group << 3 | __builtin_ctz(inGroup);
+	uint32_t groups = group + 1 < 32 ? groupMask & (~0u << (group + 1)) : 0;
+	if (!groups) return none;
+	group = __builtin_ctz(groups);
+	return group << 3 | __builtin_ctz(binMasks[group]);
+}
+
+OffsetAllocator::Allocation OffsetAllocator::allocate(uint32_t size) {
+	if (!size) size = 1;
+	uint32_t index = none;
+	uint32_t bin = findBin(binRoundUp(size));
+	if (bin != none) {
+		index = bins[bin];
+	} else {
+		// the bin below may still hold a block that fits, e.g. one exactly
+		// as large as the request.
+		for (uint32_t i = bins[binRoundDown(size)]; i != none;
+			i = nodes[i].binNext) {
+			if (nodes[i].size >= size) {
+				index = i;
+				break;
+			}
+		}
+		if (index == none) return {};
+	}
+	remove(index);
+	auto& node = nodes[index];
+	uint32_t remainder = node.size - size;
+	node.size = size;
+	node.used = true;
+	if (remainder) {
+		uint32_t rest = newNode(nodes[index].offset + size, remainder);
+		// newNode may have reallocated nodes.
+		auto& used = nodes[index];
+		nodes[rest].prev = index;
+		nodes[rest].next = used.next;
+		if (used.next != none) nodes[used.next].prev = rest;
+		used.next = rest;
+		insert(rest);
+	}
+	freeSpace -= size;
+	return {nodes[index].offset, index};
+}
+
+void OffsetAllocator::free(Allocation allocation) {
+	if (allocation.node == none) return;
+	uint32_t index = allocation.node;
+	freeSpace += nodes[index].size;
+	nodes[index].used = false;
+	// absorb free neighbors on both sides.
+	uint32_t prev = nodes[index].prev;
+	if (prev != none && !nodes[prev].used) {
+		remove(prev);
+		nodes[prev].size += nodes[index].size;
+		nodes[prev].next = nodes[index].next;
+		if (nodes[index].next != none) nodes[nodes[index].next].prev = prev;
+		unusedNodes.push_back(index);
+		index = prev;
+	}
+	uint32_t next = nodes[index].next;
+	if (next != none && !nodes[next].used) {
+		remove(next);
+		nodes[index].size += nodes[next].size;
+		nodes[index].next = nodes[next].next;
+		if (nodes[next].next != none) nodes[nodes[next].next].prev = index;
+		unusedNodes.push_back(next);
+	}
+	insert(index);
+}
+
+uint32_t OffsetAllocator::largestFree() const {
+	if (!groupMask) return 0;
+	uint32_t group = highestBit(groupMask);
+	uint32_t bin = group << 3 | highestBit(binMasks[group]);
+	// any block in the bin is at least binSize, the largest one may be
+	// bigger but finding it means walking the list.
+	return binSize(bin);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Two-level segregated fit allocator over an abstract range of units
+// (vertices, bytes, ...). Only bookkeeping lives here, the memory is
+// wherever the offsets point, e.g. a GL buffer.
+//
+// Free blocks are kept in 256 size bins: sizes below 8 get a bin each,
+// larger ones are binned by their top bit and the 3 bits below it, so bins
+// are at most 12.5% apart. Two levels of bitmasks find the first non-empty
+// bin large enough in constant time; freed blocks merge with free
+// neighbors straight away.
+struct OffsetAllocator {
+	static constexpr uint32_t none = ~0u;
+
+	struct Allocation {
+		uint32_t offset = none;
+		// internal handle, passed back to free().
+		uint32_t node = none;
+		explicit operator bool() const { return offset != none; }
+	};
+
+	uint32_t size = 0, freeSpace = 0;
+
+	static OffsetAllocator create(uint32_t size);
+	// an empty Allocation when no free block fits.
+	Allocation allocate(uint32_t size);
+	void free(Allocation allocation);
+	// size of the largest block allocate() is sure to succeed for.
+	uint32_t largestFree() const;
+
+private:
+	static constexpr int binCount = 256;
+
+	struct Node {
+		uint32_t offset, size;
+		// neighbors in the same bin's free list.
+		uint32_t binPrev = none, binNext = none;
+		// neighbors in address order.
+		uint32_t prev = none, next = none;
+		bool used = false;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> unusedNodes;
+	uint32_t groupMask = 0;
+	uint8_t binMasks[binCount / 8] = {};
+	uint32_t bins[binCount];
+
+	uint32_t newNode(uint32_t offset, uint32_t size);
+	void insert(uint32_t node);
+	void remove(uint32_t node);
+	// first non-empty bin at or above bin, or none.
+	uint32_t findBin(uint32_t bin) const;
+};
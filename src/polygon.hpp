@@ -1,50 +1,43 @@
+#pragma once
+
+#include "glstate.hpp"
+#include "layout.hpp"
+
 #include <glad/glad.h>
 
+#include <cstdint>
 #include <vector>
 
 class VertexArray {
 	GLuint VBO=0, EBO=0, VAO=0;
-	GLsizei vertexSize;
-	std::vector<GLfloat> vertices;
+	GLsizei stride;
+	std::vector<uint8_t> vertices;
 	std::vector<GLuint> indices;
 
 public:
-	static VertexArray build(GLsizei vertexSize, GLsizei vertexCount) {
+	// room for vertexCount vertices laid out as L, e.g.
+	// VertexArray::build<Layout<Attr<glm::vec3>, Attr<glm::vec2>>>(n).
+	// L's attributes take the locations from 0 up.
+	template <class L>
+	static VertexArray build(GLsizei vertexCount) {
 		VertexArray r;
-		r.vertexSize = vertexSize;
-		r.vertices.resize(vertexSize * vertexCount);
+		r.stride = L::stride;
+		r.vertices.resize(L::stride * vertexCount);
 		glGenVertexArrays(1, &r.VAO);
-		glBindVertexArray(r.VAO);
+		glState.bindVertexArray(r.VAO);
 
 		glGenBuffers(1, &r.VBO);
-		glBindBuffer(GL_ARRAY_BUFFER, r.VBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertexSize * vertexCount,
-			r.vertices.data(), GL_DYNAMIC_DRAW);
+		glState.bindBuffer(GL_ARRAY_BUFFER, r.VBO);
+		glBufferData(GL_ARRAY_BUFFER, r.vertices.size(), r.vertices.data(),
+			GL_DYNAMIC_DRAW);
+		L::apply();
 		
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glState.bindVertexArray(0);
+		glState.bindBuffer(GL_ARRAY_BUFFER, 0);
 
 		return r;
 	}
 
-	VertexArray& setAttrib(GLuint index, GLuint size, GLboolean normalized) {
-		glBindVertexArray(VAO);
-		glEnableVertexAttribArray(index);
-		GLfloat* begin = nullptr;
-		if (index != 0) {
-			GLuint prevSize=0;
-			glGetVertexAttribPointerv(index-1, GL_VERTEX_ATTRIB_ARRAY_POINTER,
-				(void**)&begin);
-			glGetVertexAttribIuiv(index-1, GL_VERTEX_ATTRIB_ARRAY_SIZE,
-				&prevSize);
-			begin += prevSize;
-		}
-		glVertexAttribPointer(index, size, GL_FLOAT, normalized,
-			this->vertexSize, (GLvoid*)begin);
-		glBindVertexArray(0);
-		return *this;
-	}
-
 	void draw() {
 		
 	}
@@ -53,5 +46,8 @@ public:
 		glDeleteBuffers(1, &VBO);
 		glDeleteBuffers(1, &EBO);
 		glDeleteVertexArrays(1, &VAO);
+		glState.forgetBuffer(VBO);
+		glState.forgetBuffer(EBO);
+		glState.forgetVertexArray(VAO);
 	}
 };
@@ -1,7 +1,8 @@
 #include "renderer.hpp"
 
+#ifndef HEADLESS
 void frameBufferResize(GLFWwindow* window, int width, int height) {
-	glViewport(0,0, width, height);
+	glState.setViewport(0,0, width, height);
 }
 
 GLFWwindow* GLFWwindow_create(int width, int height, const char* title) {
@@ -25,8 +26,9 @@ GLFWwindow* GLFWwindow_create(int width, int height, const char* title) {
 		std::cout << "Failed to initialize GLAD\n";
 		return nullptr;
 	}
+	loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
-	glViewport(0,0, width, height);
+	glState.setViewport(0,0, width, height);
 	return window;
 }
 
@@ -41,53 +43,113 @@ glm::vec2 winRes(GLFWwindow* window) {
 	glfwGetWindowSize(window, &x, &y);
 	return {(float)x, (float)y};
 }
+#endif
 
-Mesh Mesh::create(std::vector<float>&& vertices, std::vector<int>&& indices) {
+Mesh Mesh::create(std::vector<float>&& vertices, std::vector<int>&& indices,
+	const VertexFormat& format, MeshStorage storage) {
 	Mesh out;
-	out.vertices = vertices;
-	out.indices = indices;
-	out.stride = 5 * sizeof(float);
-	
-	GLuint VBO=0, EBO=0, VAO=0;
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, out.vertices.size() * sizeof(out.vertices[0]),
-		out.vertices.data(), GL_DYNAMIC_DRAW);
-//	assert(sizeof(out.vertices) == 
-//		out.vertices.size() * sizeof(out.vertices[0]));
-
-	glGenBuffers(1, &EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, out.indices.size() * sizeof(out.indices[0]),
-		out.indices.data(), GL_DYNAMIC_DRAW);
-//	assert(sizeof(out.indices) ==
-//		out.indices.size() * sizeof(out.indices[0]));
-
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, out.stride,
-		(GLvoid*)0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, out.stride,
-		(GLvoid*)(3 * sizeof(float)));
-	out.VBO = VBO;
-	out.VAO = VAO;
-	out.EBO = EBO;
+	out.format = format;
+	out.stride = format.stride;
+	out.vertexCount = vertices.size() / format.sourceStride;
+	out.indexCount = indices.size();
+
+	std::vector<uint8_t> packed;
+	if (format.normalized()) {
+		auto normalized = vertices;
+		// applied around the shader offset, so it's added in authored units.
+		out.decode = glm::translate(glm::mat4(1.f), shaderOffset)
+			* normalizePositions(normalized, format.sourceStride)
+			* glm::translate(glm::mat4(1.f), -shaderOffset);
+		packed = format.encode(normalized);
+	} else {
+		packed = format.encode(vertices);
+	}
+	auto packedIndices = IndexData::pack(indices, out.vertexCount);
+	out.indexType = packedIndices.type;
+	out.upload(packed.data(), packedIndices.bytes.data(),
+		packedIndices.bytes.size());
+
+	if (storage == MeshStorage::keep) {
+		out.storage = storage;
+		out.vertices = std::move(vertices);
+		out.indices = std::move(indices);
+	}
 	return out;
 }
 
-Renderer::Renderer(GLFWwindow* window) : program{0} {
-	glEnable(GL_DEPTH_TEST);
-	int w=0, h=0;
-	glfwGetWindowSize(window, &w, &h);
-	auto resolution = glm::vec2((float)w, (float)h);
-	this->window = window;
-	mousePos = curPos(window);
+Mesh Mesh::create(std::shared_ptr<const MappedFile> file,
+	const void* vertices, GLsizei vertexCount, const void* indices,
+	GLsizei indexCount, GLenum indexType, const VertexFormat& format,
+	const glm::mat4& decode, MeshStorage storage) {
+	Mesh out;
+	out.format = format;
+	out.stride = format.stride;
+	out.vertexCount = vertexCount;
+	out.indexCount = indexCount;
+	out.indexType = indexType;
+	out.decode = decode;
+	out.upload(vertices, indices, indexCount * IndexData::size(indexType));
+
+	if (storage == MeshStorage::mapped && file) {
+		out.storage = storage;
+		out.file = std::move(file);
+		out.packedVertices = (const uint8_t*)vertices;
+		out.packedIndices = (const uint8_t*)indices;
+	}
+	return out;
+}
 
+void Mesh::upload(const void* vertices, const void* indices,
+	size_t indexBytes) {
+	allocation = MeshArena::get(format).allocate(vertices, vertexCount,
+		indices, indexBytes);
+	auto& block = allocation.arena->blocks[allocation.block];
+	VBO = block.VBO;
+	VAO = block.VAO;
+	EBO = block.EBO;
+}
+
+Mesh::Mesh(Mesh&& other) noexcept {
+	*this = std::move(other);
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept {
+	if (this == &other) return *this;
+	release();
+	storage = other.storage;
+	vertices = std::move(other.vertices);
+	indices = std::move(other.indices);
+	file = std::move(other.file);
+	packedVertices = other.packedVertices;
+	packedIndices = other.packedIndices;
+	format = std::move(other.format);
+	stride = other.stride;
+	vertexCount = other.vertexCount;
+	indexCount = other.indexCount;
+	indexType = other.indexType;
+	VBO = other.VBO;
+	VAO = other.VAO;
+	EBO = other.EBO;
+	allocation = std::exchange(other.allocation, {});
+	decode = other.decode;
+	// other stays a valid empty mesh.
+	other.release();
+	return *this;
+}
+
+void Mesh::release() {
+	if (allocation) MeshArena::free(allocation);
+	allocation = {};
+	VBO = VAO = EBO = 0;
+	vertexCount = indexCount = 0;
+	storage = MeshStorage::discard;
+	vertices = {};
+	indices = {};
+	file.reset();
+	packedVertices = packedIndices = nullptr;
+}
+
+Mesh cubeMesh(MeshStorage storage) {
 	auto vertices = std::vector{
 		// front vertices
 		-.2f, -.2f, 0.f,	0.0f, 0.0f, // bottom left
@@ -121,12 +183,67 @@ Renderer::Renderer(GLFWwindow* window) : program{0} {
 		1, 3, 5,
 		3, 5, 7,
 	};
-	mesh = Mesh::create(std::move(vertices), std::move(indices));
+	optimizeMesh(vertices, indices, 5);
+	return Mesh::create(std::move(vertices), std::move(indices),
+		VertexFormat::compact(), storage);
+}
+
+Mesh texturedCubeMesh(int layers, MeshStorage storage) {
+	const glm::vec3 corners[] = {
+		{-.2f, -.2f, 0.f}, {.8f, -.2f, 0.f}, {-.2f, .8f, 0.f}, {.8f, .8f, 0.f},
+		{-.2f, -.2f, 1.f}, {.8f, -.2f, 1.f}, {-.2f, .8f, 1.f}, {.8f, .8f, 1.f},
+	};
+	// corners of each face: bottom left, bottom right, top left, top right.
+	// ordered so faces sharing a corner don't all get the same layer.
+	const int faces[6][4] = {
+		{0, 1, 2, 3}, // front
+		{2, 3, 6, 7}, // top
+		{1, 5, 3, 7}, // right
+		{5, 4, 7, 6}, // back
+		{4, 5, 0, 1}, // bottom
+		{4, 0, 6, 2}, // left
+	};
+	const glm::vec2 uvs[] = {{0.f, 0.f}, {1.f, 0.f}, {0.f, 1.f}, {1.f, 1.f}};
+	std::vector<float> vertices;
+	std::vector<int> indices;
+	for (int face = 0; face < 6; ++face) {
+		int first = face * 4;
+		for (int corner = 0; corner < 4; ++corner) {
+			auto& pos = corners[faces[face][corner]];
+			vertices.insert(vertices.end(), {pos.x, pos.y, pos.z,
+				uvs[corner].x, uvs[corner].y, (float)(face % layers)});
+		}
+		indices.insert(indices.end(),
+			{first, first + 1, first + 2, first + 1, first + 3, first + 2});
+	}
+	optimizeMesh(vertices, indices, 6);
+	return Mesh::create(std::move(vertices), std::move(indices),
+		VertexFormat::layered(), storage);
+}
+
+#ifndef HEADLESS
+Renderer::Renderer(GLFWwindow* window) : Renderer(winRes(window), window) {}
+#endif
+
+Renderer::Renderer(glm::vec2 resolution, GLFWwindow* window)
+	: program{0}, instancedProgram{0} {
+	glState.setDepthTest(true);
+	this->window = window;
+	mouseDelta = glm::vec2(0.f);
+	mousePos = glm::vec2(0.f);
+	uniformUploads = 0;
+#ifndef HEADLESS
+	if (window) mousePos = curPos(window);
+#endif
+
+	mesh = texturedCubeMesh(2);
 
 	program = (ShaderProgram&&)ShaderProgram::buildPath("src/vertex.glsl",
 		"src/fragment.glsl");
-	glUseProgram(program.obj);
+	glState.useProgram(program.obj);
 	LOG("Renderer::Renderer(): glError %s\n", getErrorName(glGetError()));
+	program.bindBlock("Frame", frameBinding);
+	frame = UniformBlock<FrameData>::create(frameBinding);
 	
 	{ // texture init
 		stbi_set_flip_vertically_on_load(true);
@@ -134,24 +251,25 @@ Renderer::Renderer(GLFWwindow* window) : program{0} {
 		Texture::setParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
 		Texture::setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		Texture::setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		trollcake = Uniform<Texture>::create(
-			(Texture&&)Texture::generate(GL_TEXTURE0)
-				.bind()
-				.loadFromPath("resources/trollcake.jpg")
-				.unbind(),
-			program.obj, "tex");
-		derpina = Uniform<Texture>::create(
-			(Texture&&)Texture::generate(GL_TEXTURE1)
-				.bind()
-				.loadFromPath("resources/derpina.jpg")
-				.unbind(),
-			program.obj, "tex2");
+		// a placeholder until the decoders are done, see process().
+		textures = TextureLoader::create();
+		layers = Uniform<Texture>::create(
+			textures.loadArray({"resources/trollcake.jpg",
+				"resources/derpina.jpg"}, GL_TEXTURE0),
+			program, "layers");
 	}
 	
-	glUniform1i(glGetUniformLocation(program.obj, "tex"), 0);
-	glUniform1i(glGetUniformLocation(program.obj, "tex2"), 1);
+	setUniform(layers.id, 0);
+
+	instancedProgram = (ShaderProgram&&)ShaderProgram::buildPath(
+		"src/instanced_vertex.glsl", "src/instanced_fragment.glsl");
+	instancedProgram.bindBlock("Frame", frameBinding);
+	glState.useProgram(instancedProgram.obj);
+	setUniform(instancedProgram.getUniformId("layers"), 0);
+	instancedMaterial = Material::create(instancedProgram, {layers.data});
+	glState.useProgram(program.obj);
 	struct { GLint id; float value; } redValue
-		{ glGetUniformLocation(program.obj, "redValue"), 0 };
+		{ program.getUniformId("redValue"), 0 };
 
 	float mixValue = 0.5f;
 	float delta = 0.f;
@@ -164,31 +282,28 @@ Renderer::Renderer(GLFWwindow* window) : program{0} {
 	cameraU = Uniform<Camera>::create(
 		Camera::fromTarget(glm::vec3(0.f, 0.f, 3.f),
 			glm::vec3(0.f, 0.f, 0.f)),
-		program.obj, "camera");
+		program, "camera");
 	//GLuint cameraLoc = program.getUniformId("camera");
 	
 #pragma region matrices
 	const auto id4x4 = glm::mat4(1.);
 	
-	GLuint modelLoc = program.getUniformId("model"),
-		viewLoc = program.getUniformId("view"),
-		projectionLoc = program.getUniformId("projection");
-
 	auto model = glm::rotate(id4x4, currTime * glm::radians(-55.0f),
 		glm::vec3(0.5f,1.0f, 0.f));
 	auto view = glm::lookAt(cameraU.data.pos,
 		cameraU.data.getTarget(),
 		glm::vec3(0.f, 1.f, 0.f));
 	auto projection = glm::perspective(glm::radians(45.0f),
-		(float)resolution.x / resolution.y, 0.1f, 100.0f);
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
-	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-	#define u(x) Uniform<glm::mat4>::assign(std::move(x), x##Loc)
-	this->model = u(model);
-	this->view = u(view);
-	this->projection = u(projection);
-	#undef u
+		resolution.x / resolution.y, 0.1f, 100.0f);
+	this->model = model;
+	material = Material::create(program, {layers.data});
+	frame.data.view = view;
+	frame.data.projection = projection;
+	frame.data.viewProjection = projection * view;
+	frame.data.cameraPos = glm::vec4(cameraU.data.pos, 1.f);
+	frame.data.resolution = resolution;
+	frame.data.time = 0.f;
+	flushUniforms();
 #pragma endregion
 }
 
@@ -204,6 +319,7 @@ glm::quat rotor(glm::vec3 axis, double theta) {
 	return out;
 }
 
+#ifndef HEADLESS
 void Renderer::processInput(Seconds delta) {
 	float rSpeed = glm::radians(42.f * delta);
 	float mSpeed = 1.f * delta;
@@ -247,52 +363,75 @@ void Renderer::processInput(Seconds delta) {
 	#undef kpress
 	assert(glGetError() == GL_NO_ERROR);
 }
+#endif
 
 void Renderer::process(Seconds delta, glm::vec4 clearColor) {
 	assert(glGetError() == GL_NO_ERROR);
-	auto winR = winRes(window);
-	mouseDelta = curPos(window) - mousePos;
-	mouseDelta = mouseDelta / winR * 3.f;
-	mousePos = curPos(window);
-
-	int winSize[2];
-	glfwGetWindowSize(window, winSize, winSize+1);
-	glUniform2f(glGetUniformLocation(program.obj, "resolution"),
-		(float)winSize[0], (float)winSize[1]);
-
-	processInput(delta);
-	assert(mesh.vertices[0] == -.2f);
+	FrameData next = frame.data;
+#ifndef HEADLESS
+	if (window) {
+		next.resolution = winRes(window);
+		mouseDelta = curPos(window) - mousePos;
+		mouseDelta = mouseDelta / next.resolution * 3.f;
+		mousePos = curPos(window);
+	}
+#endif
+
+#ifndef HEADLESS
+	if (window) processInput(delta);
+#endif
 	assert(mesh.VAO != 0);
 	const static auto id4x4 = glm::mat4(1.);
-	Seconds currTime = glfwGetTime();
-	glUniform1f(glGetUniformLocation(program.obj, "time"), currTime);
-	model.data = 
+	next.time += delta;
+	model =
 		// glm::rotate(id4x4, currTime * glm::radians(-55.f),
 		// glm::vec3(.5f, 1.f, 0.f));
 		id4x4;
-	glUniformMatrix4fv(model.id, 1, GL_FALSE, glm::value_ptr(model.data));
 
 	auto& camera = cameraU.data;
-	view.data = glm::lookAt(camera.pos,
+	next.view = glm::lookAt(camera.pos,
 		camera.getTarget(),
 		camera.up);
-	glUniformMatrix4fv(view.id, 1, GL_FALSE, glm::value_ptr(view.data));
-
-/*		auto vertexBuffer = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	vertexBuffer[25] = glm::sin(currTime * 2.)/2. + 1./2.;
-	vertexBuffer[8] = zigzag(currTime);
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-*/
+	next.viewProjection = next.projection * next.view;
+	next.cameraPos = glm::vec4(camera.pos, 1.f);
+	frame.set(next);
 
+	textures.poll();
 	glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// bind if another object was drawn previously;
-	trollcake.data.bind();
-	derpina.data.bind();
-//		glBindTexture(GL_TEXTURE_2D, id);
-//		glBindVertexArray(VAO);
-//		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-//		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
+	drawList.begin(next.view, 100.f);
+	drawList.submit(mesh, material, model);
+	for (auto& batch : instanced)
+		drawList.submit(batch.mesh, instancedMaterial, id4x4, &batch.instances);
+	uniformUploads = flushUniforms();
+	drawList.execute();
+	uniformUploads += drawList.stats.transformUploads;
+	for (auto& batch : batches) batch.draw(instancedMaterial);
+	MeshArena::endFrame();
+}
+
+int Renderer::flushUniforms() {
+	return frame.flush();
+}
+
+glm::mat4 Renderer::clipTransform() const {
+	const auto& f = frame.data;
+	auto& camera = cameraU.data;
+	auto aspect = glm::scale(glm::mat4(1.f),
+		glm::vec3(f.resolution.y / f.resolution.x, 1.f, 1.f));
+	return aspect * f.projection
+		* glm::lookAt(camera.pos, camera.getTarget(), camera.up);
+}
+
+Frustum Renderer::frustum() const {
+	return Frustum::fromMatrix(clipTransform());
+}
+
+InstancedBatch& Renderer::addInstanced(Mesh&& mesh,
+	const std::vector<InstanceData>& instances) {
+	auto buffer = InstanceBuffer::create(mesh, instances.size());
+	buffer.update(instances);
+	instanced.push_back({std::move(mesh), buffer});
+	return instanced.back();
 }
@@ -2,13 +2,29 @@
 
 #include "logging.h"
 #include "glm.hpp"
+#include "glstate.hpp"
+#include "arena.hpp"
+#include "batch.hpp"
+#include "culling.hpp"
+#include "drawlist.hpp"
+#include "mappedfile.hpp"
+#include "meshopt.hpp"
 #include "shader.hpp"
+#include "texloader.hpp"
 #include "texture.hpp"
+#include "vertexformat.hpp"
 
 #include <glad/glad.h>
+#ifndef HEADLESS
 #include <GLFW/glfw3.h>
+#else
+struct GLFWwindow;
+#endif
 #include <stb_image.h>
 
+#include <cstddef>
+#include <cstring>
+#include <memory>
 #include <vector>
 
 using Seconds = float;
@@ -50,51 +66,244 @@ struct Camera {
 		up = R * up;
 		return *this;
 	}
-	glm::vec3 getTarget() { return pos + dir; }
+	glm::vec3 getTarget() const { return pos + dir; }
 };
 
+inline void setUniform(GLint id, int value) { glUniform1i(id, value); }
+inline void setUniform(GLint id, float value) { glUniform1f(id, value); }
+inline void setUniform(GLint id, const glm::vec2& value) {
+	glUniform2fv(id, 1, glm::value_ptr(value));
+}
+inline void setUniform(GLint id, const glm::vec3& value) {
+	glUniform3fv(id, 1, glm::value_ptr(value));
+}
+inline void setUniform(GLint id, const glm::mat4& value) {
+	glUniformMatrix4fv(id, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+// the location is resolved once from the program's reflected uniform table,
+// upload() doesn't query the driver. values written through set() are only
+// sent by the next flush() if they changed; after writing data directly, set
+// dirty yourself.
 template <class T>
 struct Uniform {
-	GLuint id;
+	GLint id = -1;
 	T data;
-	static Uniform create(T&& data, GLuint program, const char* name) {
+	bool dirty = true;
+	static Uniform create(T&& data, const ShaderProgram& program,
+		const char* name) {
 		Uniform out;
 		out.data = data;
-		out.id = glGetUniformLocation(program, name);
+		out.id = program.getUniformId(name);
 		return out;
 	}
-	static Uniform assign(T&& data, GLuint id) {
+	static Uniform assign(T&& data, GLint id) {
 		Uniform out;
 		out.data = data;
 		out.id = id;
 		return out;
 	}
+	void set(const T& value) {
+		if (value == data) return;
+		data = value;
+		dirty = true;
+	}
+	// requires a setUniform overload for T, with the program in use.
+	void upload() const { setUniform(id, data); }
+	// returns whether a GL call was made. inactive uniforms are never sent.
+	bool flush() {
+		if (!dirty) return false;
+		dirty = false;
+		if (id < 0) return false;
+		upload();
+		return true;
+	}
+};
+
+// fixed binding points for uniform blocks shared by every program.
+enum UniformBinding : GLuint {
+	frameBinding = 0,
+};
+
+// std140 layout of the Frame block declared in the shaders. vec3s are padded
+// to vec4, and the block size is rounded up to a multiple of 16.
+struct FrameData {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 cameraPos;
+	glm::vec2 resolution;
+	Seconds time;
+	float _pad;
 };
+static_assert(offsetof(FrameData, projection) == 64);
+static_assert(offsetof(FrameData, viewProjection) == 128);
+static_assert(offsetof(FrameData, cameraPos) == 192);
+static_assert(offsetof(FrameData, resolution) == 208);
+static_assert(offsetof(FrameData, time) == 216);
+static_assert(sizeof(FrameData) == 224);
 
+// a uniform buffer bound to a fixed binding point, holding one std140 struct.
+// programs pick it up with ShaderProgram::bindBlock, so its contents are
+// uploaded once no matter how many programs read them.
+template <class T>
+struct UniformBlock {
+	GLuint UBO = 0;
+	GLuint binding = 0;
+	T data{};
+	bool dirty = true;
+	static UniformBlock create(GLuint binding) {
+		UniformBlock out;
+		out.binding = binding;
+		glGenBuffers(1, &out.UBO);
+		glState.bindBuffer(GL_UNIFORM_BUFFER, out.UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+		glState.bindBufferBase(GL_UNIFORM_BUFFER, binding, out.UBO);
+		return out;
+	}
+	void set(const T& value) {
+		if (!memcmp(&value, &data, sizeof(T))) return;
+		data = value;
+		dirty = true;
+	}
+	// returns whether a GL call was made.
+	bool flush() {
+		if (!dirty) return false;
+		dirty = false;
+		glState.bindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+		return true;
+	}
+};
+
+// the vertex shaders add this to every position before the model transform.
+const glm::vec3 shaderOffset(-.3f, -.3f, 0.f);
+
+// what a Mesh keeps of its data on the CPU once it's uploaded.
+enum class MeshStorage : uint8_t {
+	// nothing, the GL copy is the only one.
+	discard,
+	// vertices and indices as authored, for CPU queries and MeshBatch::add.
+	keep,
+	// the packed data, read in place from the file it was uploaded from,
+	// which stays mapped as long as the mesh lives.
+	mapped,
+};
+
+// the GL copy is packed by format, with the narrowest index type that
+// fits, into the format's MeshArena. VAO, VBO and EBO are the arena
+// block's, shared with the other meshes there, so draws have to pass
+// allocation.baseVertex and allocation.indexOffset. Meshes are move-only,
+// destroying one releases its range.
 struct Mesh {
+	MeshStorage storage = MeshStorage::discard;
+	// as authored, 5 floats per vertex and int indices. empty unless
+	// storage is keep.
 	std::vector<float> vertices;
 	std::vector<int> indices;
-	GLsizei stride;
-	GLuint VBO, VAO, EBO;
+	// set when storage is mapped, pointing into file.
+	std::shared_ptr<const MappedFile> file;
+	const uint8_t* packedVertices = nullptr;
+	const uint8_t* packedIndices = nullptr;
+	VertexFormat format;
+	GLsizei stride = 0;
+	GLsizei vertexCount = 0, indexCount = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+	GLuint VBO = 0, VAO = 0, EBO = 0;
+	MeshAllocation allocation;
+	// maps normalized positions back to the authored ones, identity unless
+	// the format stores snorm16 positions. DrawList applies it to the
+	// transform; instanced and batched draws expect formats without it.
+	glm::mat4 decode{1.f};
+
+	// storage can't be mapped, the authored data has no file.
 	static Mesh create(std::vector<float>&& vertices,
-		std::vector<int>&& indices);
+		std::vector<int>&& indices,
+		const VertexFormat& format = VertexFormat::standard(),
+		MeshStorage storage = MeshStorage::discard);
+	// uploads data already packed in format with indexType straight from
+	// vertices and indices, without copies on the CPU. file is what they
+	// point into, kept mapped if storage is mapped; keep isn't supported.
+	static Mesh create(std::shared_ptr<const MappedFile> file,
+		const void* vertices, GLsizei vertexCount, const void* indices,
+		GLsizei indexCount, GLenum indexType, const VertexFormat& format,
+		const glm::mat4& decode = glm::mat4(1.f),
+		MeshStorage storage = MeshStorage::mapped);
+
+	Mesh() = default;
+	Mesh(Mesh&& other) noexcept;
+	Mesh& operator=(Mesh&& other) noexcept;
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+	~Mesh() { release(); }
+	// gives the mesh's range back to the arena once the GPU is done with
+	// it and drops its CPU data. the mesh can't be drawn afterwards.
+	void release();
+private:
+	void upload(const void* vertices, const void* indices,
+		size_t indexBytes);
+};
+
+// a cube sharing its corner vertices between faces, in the compact vertex
+// format.
+Mesh cubeMesh(MeshStorage storage = MeshStorage::discard);
+// the cube the renderer draws: the same corners, but with vertices of its
+// own per face in VertexFormat::layered(). face n samples layer n % layers.
+Mesh texturedCubeMesh(int layers,
+	MeshStorage storage = MeshStorage::discard);
+
+struct InstancedBatch {
+	Mesh mesh;
+	InstanceBuffer instances;
 };
 
 struct Renderer {
 	Uniform<Camera> cameraU;
-	Uniform<glm::mat4> model, view, projection;
-	Uniform<Texture> trollcake, derpina;
+	// the cube's transform, uploaded per draw by drawList.
+	glm::mat4 model;
+	UniformBlock<FrameData> frame;
+	// decodes image files off the GL thread, polled by process().
+	TextureLoader textures;
+	// trollcake and derpina, selected per vertex by the cube and per
+	// instance by InstanceData::texIndex.
+	Uniform<Texture> layers;
 	Mesh mesh;
+	Material material;
+	// drawn with instancedProgram, one draw call per batch.
+	std::vector<InstancedBatch> instanced;
+	Material instancedMaterial;
+	// drawn after drawList with instancedMaterial, one multi-draw each.
+	std::vector<MeshBatch> batches;
+	DrawList drawList;
+	// null when rendering headless, see headless.hpp.
 	GLFWwindow* window;
-	ShaderProgram program;
+	ShaderProgram program, instancedProgram;
 	glm::vec2 mouseDelta;
 	glm::vec2 mousePos;
+	// uniform calls made by the last frame, flushUniforms() plus the
+	// draw list's transforms.
+	int uniformUploads;
+	Renderer(glm::vec2 resolution, GLFWwindow* window = nullptr);
+#ifndef HEADLESS
 	Renderer(GLFWwindow* window);
+#endif
 	static Renderer init(GLFWwindow* window);
 	void process(Seconds delta, glm::vec4 clearColor);
+	// world to clip space for the current camera, including the shaders'
+	// horizontal aspect correction. unlike frame.data.viewProjection it
+	// doesn't wait for process().
+	glm::mat4 clipTransform() const;
+	Frustum frustum() const;
+	// takes ownership of mesh and attaches an instance buffer to it.
+	InstancedBatch& addInstanced(Mesh&& mesh,
+		const std::vector<InstanceData>& instances);
+	// sends every changed uniform, once per frame before drawing.
+	int flushUniforms();
 	void processInput(Seconds delta);
 };
 
+#ifndef HEADLESS
 void frameBufferResize(GLFWwindow* window, int width, int height);
 
 GLFWwindow* GLFWwindow_create(int width, int height, const char* title);
+#endif
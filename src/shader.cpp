@@ -43,6 +43,7 @@ ShaderProgram::ShaderProgram(GLuint _obj) : obj{_obj}{}
 
 ShaderProgram::ShaderProgram(ShaderProgram&& program) {
 	obj = program.obj;
+	uniforms = std::move(program.uniforms);
 	program.obj = 0;
 }
 
@@ -50,6 +51,7 @@ ShaderProgram& ShaderProgram::operator=(ShaderProgram&& program) {
 	LOG("ShaderProgram::operator=()\n");
 	if (obj == program.obj) return *this;
 	obj = program.obj;
+	uniforms = std::move(program.uniforms);
 	program.obj = 0;
 	return *this;
 }
@@ -69,7 +71,9 @@ ShaderProgram ShaderProgram::build(Shader vertex, Shader fragment) {
 		printf("Shader program linking failed\n%s\n", infoLog);
 	}
 
-	return ShaderProgram {program};
+	ShaderProgram out {program};
+	out.reflect();
+	return out;
 }
 
 ShaderProgram ShaderProgram::buildSrc(const char* vertexShaderSource,
@@ -88,12 +92,42 @@ ShaderProgram ShaderProgram::buildPath(const char* vertexShaderPath,
 	return buildSrc(vertexShaderSrc.c_str(), fragmentShaderSrc.c_str());
 }
 
-GLuint ShaderProgram::getUniformId(const char* name) {
-	return glGetUniformLocation(obj, name);
+void ShaderProgram::reflect() {
+	uniforms.clear();
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(obj, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(obj, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::string name(maxLength, '\0');
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length = 0;
+		UniformInfo info{};
+		glGetActiveUniform(obj, i, maxLength, &length, &info.size, &info.type,
+			name.data());
+		std::string key(name.data(), length);
+		// block members have no location of their own.
+		info.location = glGetUniformLocation(obj, key.c_str());
+		LOG("ShaderProgram::reflect: %s location %d\n", key.c_str(),
+			info.location);
+		if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+			uniforms[key.substr(0, key.size() - 3)] = info;
+		uniforms[std::move(key)] = info;
+	}
+}
+
+GLint ShaderProgram::getUniformId(const char* name) const {
+	auto it = uniforms.find(name);
+	return it == uniforms.end() ? -1 : it->second.location;
+}
+
+void ShaderProgram::bindBlock(const char* name, GLuint binding) {
+	GLuint index = glGetUniformBlockIndex(obj, name);
+	if (index == GL_INVALID_INDEX) return;
+	glUniformBlockBinding(obj, index, binding);
 }
 
 ShaderProgram::~ShaderProgram() {
 	if (!obj) return;
 	LOG("ShaderProgram::~ShaderProgram()\n");
 	glDeleteProgram(obj);
+	glState.forgetProgram(obj);
 }
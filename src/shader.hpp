@@ -1,8 +1,13 @@
+#pragma once
+
 #include "logging.h"
+#include "glstate.hpp"
 
 #include <glad/glad.h>
 
 #include <fstream>
+#include <string>
+#include <unordered_map>
 
 std::string readShaderFile(const char* filePath);
 
@@ -12,15 +17,30 @@ struct Shader {
 	~Shader();
 };
 
+// what glGetActiveUniform reports for an active uniform. arrays are also
+// registered without their "[0]" suffix.
+struct UniformInfo {
+	GLint location;
+	GLint size;
+	GLenum type;
+};
+
 struct ShaderProgram {
 	GLuint obj;
+	// active uniforms by name, filled once at link time by reflect().
+	std::unordered_map<std::string, UniformInfo> uniforms;
 	ShaderProgram(GLuint);
 	ShaderProgram(const ShaderProgram&) = delete;
 	ShaderProgram& operator=(const ShaderProgram&) = delete;
 	ShaderProgram(ShaderProgram&& program);
 	ShaderProgram& operator=(ShaderProgram&& program);
 	static ShaderProgram build(Shader vertex, Shader fragment);
-	GLuint getUniformId(const char* name);
+	void reflect();
+	// -1 if the uniform is inactive, same as glGetUniformLocation.
+	GLint getUniformId(const char* name) const;
+	// attaches the named uniform block to a buffer binding point. does
+	// nothing if the program doesn't use the block.
+	void bindBlock(const char* name, GLuint binding);
 // preferred, it deletes the shaders immediately after returning the shader
 	// program.
 	static ShaderProgram buildSrc(const char* vertexShaderSource,
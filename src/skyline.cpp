@@ -0,0 +1,62 @@
+#include "skyline.hpp"
+
+#include <algorithm>
+
+SkylinePacker SkylinePacker::create(int width, int height) {
+	SkylinePacker out;
+	out.width = width;
+	out.height = height;
+	out.skyline.push_back({0, 0, width});
+	return out;
+}
+
+int SkylinePacker::fitAt(size_t index, int width, int height) const {
+	if (skyline[index].x + width > this->width) return -1;
+	int y = 0;
+	// the segments under the rectangle always reach far enough, they
+	// cover the whole width.
+	for (int left = width; left > 0; left -= skyline[index++].width) {
+		y = std::max(y, skyline[index].y);
+		if (y + height > this->height) return -1;
+	}
+	return y;
+}
+
+bool SkylinePacker::pack(int width, int height, AtlasRect& out) {
+	if (width <= 0 || height <= 0) {
+		out = {0, 0, 0, 0};
+		return true;
+	}
+	size_t best = skyline.size();
+	int bestY = this->height;
+	for (size_t i = 0; i < skyline.size(); ++i) {
+		int y = fitAt(i, width, height);
+		if (y >= 0 && y < bestY) {
+			best = i;
+			bestY = y;
+		}
+	}
+	if (best == skyline.size()) return false;
+
+	out = {skyline[best].x, bestY, width, height};
+	skyline.insert(skyline.begin() + best, {out.x, bestY + height, width});
+	// cut what's now under the new segment off the ones after it.
+	for (size_t i = best + 1; i < skyline.size();) {
+		int overlap = out.x + width - skyline[i].x;
+		if (overlap <= 0) break;
+		skyline[i].x += overlap;
+		skyline[i].width -= overlap;
+		if (skyline[i].width > 0) break;
+		skyline.erase(skyline.begin() + i);
+	}
+	for (size_t i = 0; i + 1 < skyline.size();) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		} else {
+			++i;
+		}
+	}
+	used += (long)width * height;
+	return true;
+}
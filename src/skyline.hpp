@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct AtlasRect {
+	int x, y, width, height;
+};
+
+// Skyline bottom-left rectangle packer: the packed area is kept as a list
+// of horizontal segments, and each rectangle goes where its top ends up
+// lowest. Good for many small images of similar height, sort them by
+// height first.
+struct SkylinePacker {
+	int width = 0, height = 0;
+	// pixels covered by packed rectangles.
+	long used = 0;
+
+	static SkylinePacker create(int width, int height);
+	// false if the rectangle doesn't fit anywhere.
+	bool pack(int width, int height, AtlasRect& out);
+	float occupancy() const {
+		return width && height ? (float)used / ((long)width * height) : 0.f;
+	}
+
+private:
+	struct Segment {
+		int x, y, width;
+	};
+	std::vector<Segment> skyline;
+	// top of a width wide rectangle placed at segment index, -1 if it
+	// doesn't fit there.
+	int fitAt(size_t index, int width, int height) const;
+};
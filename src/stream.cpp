@@ -0,0 +1,92 @@
+#include "stream.hpp"
+#include "logging.h"
+
+StreamBuffer StreamBuffer::create(GLenum target, GLsizeiptr regionSize) {
+	StreamBuffer out;
+	out.target = target;
+	out.regionSize = regionSize;
+	out.persistent = GLEXT_buffer_storage;
+	const GLsizeiptr size = regionSize * regionCount;
+	glGenBuffers(1, &out.buffer);
+	glState.bindBuffer(target, out.buffer);
+	if (out.persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT
+			| GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, size, nullptr, flags);
+		out.mapped = (unsigned char*)glMapBufferRange(target, 0, size, flags);
+		if (!out.mapped) {
+			LOG("StreamBuffer::create: persistent map failed\n");
+			out.persistent = false;
+		}
+	}
+	if (!out.persistent) {
+		// immutable storage can't be respecified, start over.
+		if (GLEXT_buffer_storage) {
+			glDeleteBuffers(1, &out.buffer);
+			glState.forgetBuffer(out.buffer);
+			glGenBuffers(1, &out.buffer);
+			glState.bindBuffer(target, out.buffer);
+		}
+		glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+		out.staging.resize(size);
+		out.mapped = out.staging.data();
+	}
+	return out;
+}
+
+void StreamBuffer::beginFrame() {
+	region = (region + 1) % regionCount;
+	head = flushed = 0;
+	GLsync& fence = fences[region];
+	if (!fence) return;
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		++stats.stalls;
+		while (status == GL_TIMEOUT_EXPIRED)
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+				1000000);
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void* StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment,
+	GLintptr* offset) {
+	GLintptr base = region * regionSize;
+	GLintptr start = (base + head + alignment - 1) / alignment * alignment;
+	if (start + size > base + regionSize) return nullptr;
+	head = start + size - base;
+	*offset = start;
+	return mapped + start;
+}
+
+void StreamBuffer::flush() {
+	if (persistent || head == flushed) return;
+	GLintptr base = region * regionSize;
+	glState.bindBuffer(target, buffer);
+	glBufferSubData(target, base + flushed, head - flushed,
+		mapped + base + flushed);
+	flushed = head;
+}
+
+void StreamBuffer::endFrame() {
+	flush();
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::destroy() {
+	for (auto& fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (!buffer) return;
+	if (persistent) {
+		glState.bindBuffer(target, buffer);
+		glUnmapBuffer(target);
+	}
+	glDeleteBuffers(1, &buffer);
+	glState.forgetBuffer(buffer);
+	buffer = 0;
+	mapped = nullptr;
+	staging.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "glext.hpp"
+#include "glstate.hpp"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Ring buffer for data written every frame (instances, indirect commands,
+// dynamic vertices). The buffer is split into regionCount per-frame regions;
+// a region is fenced when its frame ends and only written again once the GPU
+// is done with it, so writes never stall on an orphan or an implicit sync.
+//
+// With buffer storage the whole buffer stays persistently and coherently
+// mapped, and allocate() hands out pointers straight into it. Without it,
+// writes go to a staging copy that flush() uploads with one glBufferSubData.
+struct StreamBuffer {
+	static constexpr int regionCount = 3;
+	struct Stats {
+		// times beginFrame() had to block on a fence.
+		unsigned long stalls = 0;
+	} stats;
+	GLuint buffer = 0;
+	GLsizeiptr regionSize = 0;
+	bool persistent = false;
+
+	// binds the buffer to target while creating it.
+	static StreamBuffer create(GLenum target, GLsizeiptr regionSize);
+	// waits until the next region is free and starts writing there.
+	void beginFrame();
+	// returns where to write size bytes, or nullptr if the region is full.
+	// offset receives the absolute offset in the buffer, aligned to
+	// alignment (which doesn't need to be a power of two).
+	void* allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset);
+	// makes this frame's writes visible to the GPU, call before drawing.
+	void flush();
+	// fences the region once the frame's draws are issued.
+	void endFrame();
+	void destroy();
+
+private:
+	GLenum target = 0;
+	unsigned char* mapped = nullptr;
+	std::vector<unsigned char> staging;
+	GLsync fences[regionCount] = {};
+	int region = regionCount - 1;
+	GLsizeiptr head = 0, flushed = 0;
+};
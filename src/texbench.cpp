@@ -0,0 +1,104 @@
+#include "headless.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+// Texture upload benchmark: uploads a size x size image into a fresh
+// texture for each format and prints MB/s of decoded pixels as JSON:
+//	legacy       glTexImage2D GL_RGB, unpack alignment 1, the old path
+//	r8 .. rgba8  Texture::allocate + upload, immutable storage if supported
+//	rgb8_rgba    3 channels expanded to RGBA8 on the cpu first, included
+//	             in the time
+// Mipmaps aren't generated, every run ends with glFinish.
+//
+// usage: texbench [--size n] [--runs n]
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start)
+		.count();
+}
+
+int main(int argc, char** argv) {
+	int size = 2048, runs = 10;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		#define arg(x) (!strcmp(argv[i], x))
+		if arg("--size") size = atoi(argv[i+1]);
+		else if arg("--runs") runs = atoi(argv[i+1]);
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return -1;
+		}
+		#undef arg
+	}
+
+	runs = std::max(runs, 1);
+	auto context = HeadlessContext::create(64, 64);
+	if (!context) return -1;
+
+	size_t pixels = (size_t)size * size;
+	std::vector<unsigned char> source(pixels * 4), expanded(pixels * 4);
+	for (size_t i = 0; i < source.size(); ++i)
+		source[i] = (unsigned char)(i * 7 + i / 4096);
+
+	struct Path {
+		const char* name;
+		int channels;
+		bool expandRgb, legacy;
+	};
+	const Path paths[] = {
+		{"legacy", 3, false, true},
+		{"r8", 1, false, false},
+		{"rg8", 2, false, false},
+		{"rgb8", 3, false, false},
+		{"rgb8_rgba", 3, true, false},
+		{"rgba8", 4, false, false},
+	};
+
+	printf("{\n\t\"renderer\": \"%s\",\n\t\"size\": %d,\n\t\"runs\": %d,\n"
+		"\t\"paths\": {\n", (const char*)glGetString(GL_RENDERER), size, runs);
+	for (auto& path : paths) {
+		auto format = PixelFormat::forChannels(path.channels, path.expandRgb);
+		std::vector<double> times;
+		for (int run = 0; run < runs; ++run) {
+			auto texture = Texture::generate(GL_TEXTURE0);
+			auto start = Clock::now();
+			texture.bind();
+			if (path.legacy) {
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size, size, 0, GL_RGB,
+					GL_UNSIGNED_BYTE, source.data());
+			} else {
+				const unsigned char* data = source.data();
+				if (format.expandRgb) {
+					expandRgbToRgba(data, expanded.data(), pixels);
+					data = expanded.data();
+				}
+				texture.allocate(size, size, format, 1)
+					.upload(data, size, size, format);
+			}
+			glFinish();
+			times.push_back(msSince(start));
+			texture.unbind();
+			glDeleteTextures(1, &texture.id);
+			glState.forgetTexture(texture.id);
+		}
+		std::sort(times.begin(), times.end());
+		double bytes = (double)pixels * path.channels,
+			median = times[times.size() / 2];
+		printf("\t\t\"%s\": {\"best_ms\": %.3f, \"median_ms\": %.3f, "
+			"\"mb_per_s\": %.1f}%s\n", path.name, times.front(), median,
+			bytes / (1 << 20) / (median / 1000.),
+			&path == &paths[std::size(paths) - 1] ? "" : ",");
+	}
+	printf("\t}\n}\n");
+	context.destroy();
+	return 0;
+}
@@ -0,0 +1,235 @@
+#include "texcache.hpp"
+#include "mappedfile.hpp"
+#include "texloader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// everything TextureRefs point at, so the TextureCache itself can move.
+struct TextureRef::Shared {
+	struct Entry {
+		GLuint id = 0;
+		// every path that resolved to this texture.
+		std::vector<std::string> paths;
+		uint64_t hash = 0;
+		size_t bytes = 0;
+		int refs = 0;
+		bool live = false, released = false;
+		// in lru while released.
+		std::list<uint32_t>::iterator lru;
+	};
+	// what a path was when it was last loaded.
+	struct File {
+		uintmax_t size;
+		fs::file_time_type modified;
+		uint32_t slot;
+	};
+
+	TextureLoader* loader = nullptr;
+	std::vector<Entry> entries;
+	std::vector<uint32_t> freeSlots;
+	std::unordered_map<std::string, File> byPath;
+	std::unordered_map<uint64_t, uint32_t> byContent;
+	// released textures, least recently released first.
+	std::list<uint32_t> lru;
+	TextureCache::Stats stats{};
+
+	~Shared() {
+		for (auto& entry : entries) {
+			if (!entry.live) continue;
+			glDeleteTextures(1, &entry.id);
+			glState.forgetTexture(entry.id);
+		}
+	}
+
+	void acquire(uint32_t slot) {
+		auto& entry = entries[slot];
+		if (entry.refs++ == 0 && entry.released) {
+			lru.erase(entry.lru);
+			entry.released = false;
+		}
+	}
+
+	void release(uint32_t slot) {
+		auto& entry = entries[slot];
+		if (--entry.refs > 0) return;
+		entry.lru = lru.insert(lru.end(), slot);
+		entry.released = true;
+		trim();
+	}
+
+	void trim() {
+		for (auto it = lru.begin();
+			it != lru.end() && stats.residentBytes > stats.budget;) {
+			uint32_t slot = *it;
+			auto& entry = entries[slot];
+			// the loader would upload into a deleted (or reused) name.
+			if (loader->loading(Texture{entry.id})) {
+				++it;
+				continue;
+			}
+			it = lru.erase(it);
+			evict(slot);
+		}
+	}
+
+	void evict(uint32_t slot) {
+		auto& entry = entries[slot];
+		glDeleteTextures(1, &entry.id);
+		glState.forgetTexture(entry.id);
+		for (auto& path : entry.paths) {
+			auto file = byPath.find(path);
+			if (file != byPath.end() && file->second.slot == slot)
+				byPath.erase(file);
+		}
+		byContent.erase(entry.hash);
+		stats.residentBytes -= entry.bytes;
+		stats.textures--;
+		stats.evictions++;
+		entry = Entry{};
+		freeSlots.push_back(slot);
+	}
+
+	TextureRef ref(uint32_t slot, GLenum unitIndex) {
+		TextureRef out;
+		out.texture = {entries[slot].id, unitIndex};
+		out.cache = this;
+		out.slot = slot;
+		acquire(slot);
+		return out;
+	}
+};
+
+TextureRef::TextureRef(const TextureRef& other)
+	: texture(other.texture), cache(other.cache), slot(other.slot) {
+	if (cache) cache->acquire(slot);
+}
+
+TextureRef::TextureRef(TextureRef&& other) noexcept
+	: texture(other.texture), cache(other.cache), slot(other.slot) {
+	other.texture = {};
+	other.cache = nullptr;
+}
+
+TextureRef& TextureRef::operator=(TextureRef other) noexcept {
+	std::swap(texture, other.texture);
+	std::swap(cache, other.cache);
+	std::swap(slot, other.slot);
+	return *this;
+}
+
+TextureRef::~TextureRef() {
+	if (cache) cache->release(slot);
+}
+
+TextureCache::TextureCache() = default;
+TextureCache::TextureCache(TextureCache&&) = default;
+TextureCache& TextureCache::operator=(TextureCache&&) = default;
+TextureCache::~TextureCache() = default;
+
+TextureCache TextureCache::create(TextureLoader& loader, size_t budget) {
+	TextureCache out;
+	out.shared = std::make_unique<TextureRef::Shared>();
+	out.shared->loader = &loader;
+	out.shared->stats.budget = budget;
+	return out;
+}
+
+static uint64_t fnv1a(const uint8_t* data, size_t size) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+TextureRef TextureCache::load(const char* imagePath, GLenum unitIndex) {
+	auto& cache = *shared;
+	std::error_code error;
+	auto key = fs::absolute(imagePath, error).lexically_normal().string();
+	auto size = fs::file_size(imagePath, error);
+	auto modified = fs::last_write_time(imagePath, error);
+	if (error) {
+		std::cout << "Failed to load texture " << imagePath << '\n';
+		return {};
+	}
+	auto known = cache.byPath.find(key);
+	if (known != cache.byPath.end() && known->second.size == size
+		&& known->second.modified == modified) {
+		cache.stats.hits++;
+		return cache.ref(known->second.slot, unitIndex);
+	}
+
+	auto file = MappedFile::open(imagePath);
+	if (!file) {
+		std::cout << "Failed to load texture " << imagePath << '\n';
+		return {};
+	}
+	uint64_t hash = fnv1a(file.data, file.size);
+	auto same = cache.byContent.find(hash);
+	if (same != cache.byContent.end()) {
+		cache.stats.contentHits++;
+		uint32_t slot = same->second;
+		auto& paths = cache.entries[slot].paths;
+		if (std::find(paths.begin(), paths.end(), key) == paths.end())
+			paths.push_back(key);
+		cache.byPath[key] = {size, modified, slot};
+		return cache.ref(slot, unitIndex);
+	}
+
+	// a changed file under a known path gets a texture of its own, the old
+	// one stays cached under its hash.
+	cache.stats.misses++;
+	uint32_t slot;
+	if (cache.freeSlots.empty()) {
+		slot = cache.entries.size();
+		cache.entries.emplace_back();
+	} else {
+		slot = cache.freeSlots.back();
+		cache.freeSlots.pop_back();
+	}
+	auto& entry = cache.entries[slot];
+	entry.id = cache.loader->load(imagePath, unitIndex).id;
+	entry.paths = {key};
+	entry.hash = hash;
+	entry.live = true;
+	int width, height, channels;
+	if (stbi_info(imagePath, &width, &height, &channels)) {
+		auto format = PixelFormat::forChannels(channels,
+			cache.loader->expandRgb);
+		// a full mip chain adds a third.
+		entry.bytes = (size_t)width * height * format.texelSize() * 4 / 3;
+	} else {
+		entry.bytes = 4;
+	}
+	cache.byPath[key] = {size, modified, slot};
+	cache.byContent[hash] = slot;
+	cache.stats.residentBytes += entry.bytes;
+	cache.stats.textures++;
+	auto out = cache.ref(slot, unitIndex);
+	cache.trim();
+	return out;
+}
+
+void TextureCache::trim() {
+	if (shared) shared->trim();
+}
+
+void TextureCache::setBudget(size_t bytes) {
+	shared->stats.budget = bytes;
+	shared->trim();
+}
+
+const TextureCache::Stats& TextureCache::stats() const {
+	return shared->stats;
+}
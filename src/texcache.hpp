@@ -0,0 +1,74 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct TextureLoader;
+struct TextureCache;
+
+// A counted reference to a texture in a TextureCache. While any reference
+// to it exists the texture stays resident; copies share it.
+struct TextureRef {
+	// on the unit the reference was loaded for.
+	Texture texture;
+	operator bool() const { return texture.id; }
+
+	TextureRef() = default;
+	TextureRef(const TextureRef& other);
+	TextureRef(TextureRef&& other) noexcept;
+	TextureRef& operator=(TextureRef other) noexcept;
+	~TextureRef();
+
+private:
+	friend TextureCache;
+	struct Shared;
+	Shared* cache = nullptr;
+	uint32_t slot = 0;
+};
+
+// Textures shared by everything that loads the same image: by path, as
+// long as the file's size and modification time are unchanged, and
+// otherwise by the 64-bit FNV-1a hash of the file's bytes, so copies under
+// another name share one texture too. Loading goes through a TextureLoader,
+// so a miss hands out a placeholder like TextureLoader::load.
+//
+// Once its last TextureRef is gone a texture stays cached but becomes
+// evictable; whenever the estimated VRAM of all cached textures is over
+// budget, the least recently released ones are deleted. Referenced
+// textures and ones still loading are never evicted, so the budget can be
+// exceeded. Every TextureRef has to be gone before the cache is destroyed,
+// and the loader has to outlive it.
+struct TextureCache {
+	struct Stats {
+		// same path and file, or same bytes under another path.
+		long hits, contentHits;
+		long misses, evictions;
+		// estimated, mip chains included.
+		size_t residentBytes, budget;
+		int textures;
+	};
+
+	static TextureCache create(TextureLoader& loader,
+		size_t budget = 256 << 20);
+
+	// on the GL thread. An empty reference if the file can't be read.
+	TextureRef load(const char* imagePath, GLenum unitIndex);
+	// evicts released textures, least recently used first, until the
+	// cache fits its budget. load() and dropping a reference do this too.
+	void trim();
+	void setBudget(size_t bytes);
+	const Stats& stats() const;
+
+	TextureCache();
+	TextureCache(TextureCache&&);
+	TextureCache& operator=(TextureCache&&);
+	~TextureCache();
+
+private:
+	std::unique_ptr<TextureRef::Shared> shared;
+};
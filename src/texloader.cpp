@@ -0,0 +1,310 @@
+#include "texloader.hpp"
+#include "lockfree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Jobs go to the workers under a mutex, they're rare and the workers sleep
+// on it. Results come back through the MpscQueue so poll() never takes a
+// lock a decoder might be holding.
+struct TextureLoader::Pool {
+	struct Job {
+		std::string path;
+		Texture texture;
+		// from the header read by load(), or the array's layer size.
+		int width, height;
+		PixelFormat format;
+		// -1 for GL_TEXTURE_2D.
+		GLint layer;
+		// the load() or loadArray() call, see inFlight.
+		uint32_t ticket;
+	};
+	struct Image {
+		Job job;
+		// from stbi_load, null if decoding failed or it was converted.
+		unsigned char* decoded;
+		// resized and/or expanded to RGBA.
+		std::vector<unsigned char> converted;
+		// null if decoding failed.
+		const unsigned char* pixels() const {
+			return decoded ? decoded
+				: converted.empty() ? nullptr : converted.data();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Job> jobs;
+	bool quit = false;
+	MpscQueue<Image> done;
+
+	Pool(int workers) {
+		for (int i = 0; i < workers; ++i)
+			threads.emplace_back([this] { loop(); });
+	}
+
+	~Pool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (auto& thread : threads) thread.join();
+		for (Image image; done.pop(image);) stbi_image_free(image.decoded);
+	}
+
+	void loop() {
+		for (;;) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return quit || !jobs.empty(); });
+				if (quit) return;
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			done.push(decode(std::move(job)));
+		}
+	}
+
+	static Image decode(Job&& job) {
+		Image image{std::move(job), nullptr, {}};
+		auto& format = image.job.format;
+		int width, height, channels;
+		unsigned char* pixels = stbi_load(image.job.path.c_str(), &width,
+			&height, &channels, format.channels);
+		if (!pixels) return image;
+		if (width != image.job.width || height != image.job.height) {
+			// a 2D texture's file changed since load() read the header, its
+			// storage won't fit. array layers are scaled to fit.
+			if (image.job.layer >= 0)
+				image.converted = resizeImage(pixels, width, height,
+					format.channels, image.job.width, image.job.height);
+			stbi_image_free(pixels);
+			if (image.converted.empty()) return image;
+			pixels = nullptr;
+		}
+		if (format.expandRgb) {
+			size_t count = (size_t)image.job.width * image.job.height;
+			std::vector<unsigned char> expanded(count * 4);
+			expandRgbToRgba(pixels ? pixels : image.converted.data(),
+				expanded.data(), count);
+			image.converted = std::move(expanded);
+			stbi_image_free(pixels);
+			pixels = nullptr;
+		}
+		image.decoded = pixels;
+		return image;
+	}
+};
+
+static const unsigned char* placeholderTexel(const PixelFormat& format) {
+	static const unsigned char greyAlpha[] = {128, 255};
+	return format.channels == 2 ? greyAlpha : TextureLoader::placeholder;
+}
+
+TextureLoader::TextureLoader() = default;
+
+TextureLoader::TextureLoader(TextureLoader&& other) {
+	*this = std::move(other);
+}
+
+TextureLoader& TextureLoader::operator=(TextureLoader&& other) {
+	std::swap(expandRgb, other.expandRgb);
+	std::swap(stats, other.stats);
+	std::swap(pool, other.pool);
+	std::swap(inFlight, other.inFlight);
+	std::swap(tickets, other.tickets);
+	std::swap(nextTicket, other.nextTicket);
+	std::swap(PBO, other.PBO);
+	return *this;
+}
+
+TextureLoader::~TextureLoader() {
+	if (PBO) {
+		glDeleteBuffers(1, &PBO);
+		glState.forgetBuffer(PBO);
+	}
+}
+
+TextureLoader TextureLoader::create(int threads) {
+	TextureLoader out;
+	if (threads <= 0) threads = std::thread::hardware_concurrency();
+	out.pool = std::make_unique<Pool>(std::max(threads, 1));
+	return out;
+}
+
+Texture TextureLoader::load(const char* imagePath, GLenum unitIndex) {
+	auto texture = Texture::generate(unitIndex);
+	stats.queued++;
+	int width, height, channels;
+	if (!stbi_info(imagePath, &width, &height, &channels)) {
+		std::cout << "Failed to load texture " << imagePath << '\n';
+		stats.failed++;
+		// still a valid texture, just a placeholder for good.
+		auto format = PixelFormat::forChannels(4);
+		texture.bind().allocate(1, 1, format).upload(placeholder, 1, 1, format)
+			.unbind();
+		return texture;
+	}
+	auto format = PixelFormat::forChannels(channels, expandRgb);
+	// the placeholder is the 1x1 level, sampled alone until poll()
+	// uploads level 0 and lowers the base level again.
+	GLsizei last = Texture::levelsFor(width, height) - 1;
+	texture.bind()
+		.allocate(width, height, format)
+		.upload(placeholderTexel(format), 1, 1, format, last);
+	Texture::setParameter(GL_TEXTURE_BASE_LEVEL, last);
+	texture.unbind();
+	uint32_t ticket = track(texture, 1);
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->jobs.push_back({imagePath, texture, width, height, format, -1,
+			ticket});
+	}
+	pool->wake.notify_one();
+	return texture;
+}
+
+Texture TextureLoader::loadArray(const std::vector<const char*>& imagePaths,
+	GLenum unitIndex, int width, int height) {
+	auto texture = Texture::generate(unitIndex, GL_TEXTURE_2D_ARRAY);
+	if (imagePaths.empty()) return texture;
+	// enough channels for every layer, stb_image converts the rest.
+	int channels = 1;
+	for (auto path : imagePaths) {
+		int w, h, c;
+		if (!stbi_info(path, &w, &h, &c)) continue;
+		channels = std::max(channels, c);
+		if (width <= 0 || height <= 0) {
+			width = w;
+			height = h;
+		}
+	}
+	// nothing readable, every layer fails to a 1x1 placeholder.
+	if (width <= 0 || height <= 0) width = height = 1;
+
+	auto format = PixelFormat::forChannels(channels, expandRgb);
+	GLsizei layers = imagePaths.size(),
+		last = Texture::levelsFor(width, height) - 1;
+	texture.bind().allocateLayers(width, height, layers, format);
+	for (GLint layer = 0; layer < layers; ++layer)
+		texture.uploadLayer(placeholderTexel(format), 1, 1, layer, format,
+			last);
+	Texture::setParameter(GL_TEXTURE_BASE_LEVEL, last, GL_TEXTURE_2D_ARRAY);
+	texture.unbind();
+	uint32_t ticket = track(texture, layers);
+	stats.queued += layers;
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		for (GLint layer = 0; layer < layers; ++layer)
+			pool->jobs.push_back({imagePaths[layer], texture, width, height,
+				format, layer, ticket});
+	}
+	pool->wake.notify_all();
+	return texture;
+}
+
+uint32_t TextureLoader::track(const Texture& texture, int images) {
+	// a name still loading was deleted and handed out again, the old
+	// load's results must not land in the new texture.
+	auto old = tickets.find(texture.id);
+	if (old != tickets.end()) inFlight.erase(old->second);
+	uint32_t ticket = nextTicket++;
+	tickets[texture.id] = ticket;
+	inFlight[ticket] = images;
+	return ticket;
+}
+
+void TextureLoader::untrack(uint32_t ticket, GLuint id) {
+	inFlight.erase(ticket);
+	auto current = tickets.find(id);
+	if (current != tickets.end() && current->second == ticket)
+		tickets.erase(current);
+}
+
+int TextureLoader::poll() {
+	if (!pool) return 0;
+	int uploaded = 0;
+	for (Pool::Image image; pool->done.pop(image);) {
+		auto& job = image.job;
+		// superseded by another load into the same name, or deleted.
+		auto left = inFlight.find(job.ticket);
+		if (left == inFlight.end() || !glIsTexture(job.texture.id)) {
+			stats.failed++;
+			if (left != inFlight.end() && --left->second == 0)
+				untrack(job.ticket, job.texture.id);
+			stbi_image_free(image.decoded);
+			continue;
+		}
+		GLsizeiptr size = (GLsizeiptr)job.width * job.height
+			* job.format.texelSize();
+		const void* source = image.pixels();
+		std::vector<unsigned char> fill;
+		if (!source) {
+			std::cout << "Failed to load texture " << job.path << '\n';
+			stats.failed++;
+			// a 2D texture keeps showing its placeholder, but an array's
+			// base level goes back to 0 once the other layers are in.
+			if (job.layer < 0) {
+				untrack(job.ticket, job.texture.id);
+				continue;
+			}
+			auto texel = placeholderTexel(job.format);
+			int texelSize = job.format.texelSize();
+			fill.resize(size);
+			for (GLsizeiptr i = 0; i < size; ++i)
+				fill[i] = texel[i % texelSize];
+			source = fill.data();
+		} else {
+			stats.uploaded++;
+			uploaded++;
+		}
+
+		if (!PBO) glGenBuffers(1, &PBO);
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+		// orphan the previous upload's storage instead of waiting on it.
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped) {
+			memcpy(mapped, source, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			source = nullptr;
+		} else {
+			glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		auto& texture = job.texture;
+		texture.bind();
+		if (job.layer < 0)
+			texture.upload(source, job.width, job.height, job.format);
+		else
+			texture.uploadLayer(source, job.width, job.height, job.layer,
+				job.format);
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		stbi_image_free(image.decoded);
+
+		if (--left->second == 0) {
+			untrack(job.ticket, texture.id);
+			Texture::setParameter(GL_TEXTURE_BASE_LEVEL, 0, texture.target);
+			glGenerateMipmap(texture.target);
+		}
+		texture.unbind();
+	}
+	return uploaded;
+}
+
+void TextureLoader::finish() {
+	while (poll(), pending() > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
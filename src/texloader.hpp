@@ -0,0 +1,72 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <glad/glad.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Decodes image files on a pool of worker threads and uploads them on the
+// GL thread. load() reads the image header, allocates the texture's
+// storage and hands it out right away, sampling a grey placeholder from its
+// last (1x1) mip level. Decoded pixels come back through a lock-free queue
+// and poll() streams them into their textures through a pixel buffer
+// object, so the GL thread never waits for a decode.
+struct TextureLoader {
+	// grey, with opaque alpha.
+	static constexpr unsigned char placeholder[4] = {128, 128, 128, 255};
+	// see PixelFormat. expansion happens on the decoder threads.
+	bool expandRgb = true;
+
+	struct Stats {
+		// failed includes images dropped because their texture was
+		// deleted before the upload.
+		int queued, uploaded, failed;
+	};
+	Stats stats{};
+
+	// threads are decoders besides the GL thread, 0 picks one per hardware
+	// thread.
+	static TextureLoader create(int threads = 0);
+
+	// on the GL thread: a texture on unitIndex that shows the image at
+	// imagePath once poll() has uploaded it.
+	Texture load(const char* imagePath, GLenum unitIndex);
+	// a GL_TEXTURE_2D_ARRAY with one layer per image, of width x height or
+	// the size of the first readable image. Images of another size are
+	// scaled to fit on the decoder threads; the placeholder shows until
+	// every layer is in.
+	Texture loadArray(const std::vector<const char*>& imagePaths,
+		GLenum unitIndex, int width = 0, int height = 0);
+	// uploads every image decoded so far, once per frame. Returns how many.
+	int poll();
+	// polls until every load() is uploaded or has failed.
+	void finish();
+	// images still decoding or waiting for poll().
+	int pending() const { return stats.queued - stats.uploaded - stats.failed; }
+	// true until every image of texture has been uploaded or has failed.
+	bool loading(const Texture& texture) const {
+		return tickets.count(texture.id);
+	}
+
+	TextureLoader();
+	TextureLoader(TextureLoader&&);
+	TextureLoader& operator=(TextureLoader&&);
+	~TextureLoader();
+
+private:
+	struct Pool;
+	std::unique_ptr<Pool> pool;
+	// images still to come per load() or loadArray() call, by ticket. GL
+	// names can be reused once a texture is deleted, tickets aren't.
+	std::unordered_map<uint32_t, int> inFlight;
+	// the ticket of the load still filling each texture, by id.
+	std::unordered_map<GLuint, uint32_t> tickets;
+	uint32_t nextTicket = 0;
+	uint32_t track(const Texture& texture, int images);
+	void untrack(uint32_t ticket, GLuint id);
+	// orphaned and refilled for each upload.
+	GLuint PBO = 0;
+};
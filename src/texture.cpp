@@ -1,28 +1,183 @@
 #include "texture.hpp"
+#include "glext.hpp"
 
-Texture Texture::generate(GLenum unitIndex) {
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define EXPAND_X86
+	#include <immintrin.h>
+#endif
+
+PixelFormat PixelFormat::forChannels(int channels, bool expandRgb) {
+	switch (channels) {
+	case 1: return {GL_R8, GL_RED, 1, false};
+	case 2: return {GL_RG8, GL_RG, 2, false};
+	case 4: return {GL_RGBA8, GL_RGBA, 4, false};
+	default:
+		if (expandRgb) return {GL_RGBA8, GL_RGBA, 3, true};
+		return {GL_RGB8, GL_RGB, 3, false};
+	}
+}
+
+#ifdef EXPAND_X86
+// returns how many pixels it expanded, the caller does the rest.
+__attribute__((target("ssse3")))
+static size_t expandSSSE3(const unsigned char* rgb, unsigned char* rgba,
+	size_t pixels) {
+	// 4 pixels per step from a 16 byte load, so stop while 16 bytes are
+	// still in range.
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8,
+		-1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+	size_t i = 0;
+	for (; i + 6 <= pixels; i += 4) {
+		__m128i in = _mm_loadu_si128((const __m128i*)(rgb + i * 3));
+		_mm_storeu_si128((__m128i*)(rgba + i * 4),
+			_mm_or_si128(_mm_shuffle_epi8(in, shuffle), alpha));
+	}
+	return i;
+}
+#endif
+
+void expandRgbToRgba(const unsigned char* rgb, unsigned char* rgba,
+	size_t pixels) {
+	size_t i = 0;
+#ifdef EXPAND_X86
+	static const bool ssse3 = __builtin_cpu_supports("ssse3");
+	if (ssse3) i = expandSSSE3(rgb, rgba, pixels);
+#endif
+	for (; i < pixels; ++i) {
+		rgba[i * 4] = rgb[i * 3];
+		rgba[i * 4 + 1] = rgb[i * 3 + 1];
+		rgba[i * 4 + 2] = rgb[i * 3 + 2];
+		rgba[i * 4 + 3] = 255;
+	}
+}
+
+std::vector<unsigned char> resizeImage(const unsigned char* pixels,
+	int width, int height, int channels, int toWidth, int toHeight) {
+	std::vector<unsigned char> out((size_t)toWidth * toHeight * channels);
+	// texel centers line up, edges clamp.
+	float scaleX = (float)width / toWidth, scaleY = (float)height / toHeight;
+	for (int y = 0; y < toHeight; ++y) {
+		float fy = std::clamp((y + .5f) * scaleY - .5f, 0.f, height - 1.f);
+		int y0 = (int)fy, y1 = std::min(y0 + 1, height - 1);
+		float ty = fy - y0;
+		for (int x = 0; x < toWidth; ++x) {
+			float fx = std::clamp((x + .5f) * scaleX - .5f, 0.f, width - 1.f);
+			int x0 = (int)fx, x1 = std::min(x0 + 1, width - 1);
+			float tx = fx - x0;
+			auto texel = [&](int x, int y) {
+				return pixels + ((size_t)y * width + x) * channels;
+			};
+			auto a = texel(x0, y0), b = texel(x1, y0), c = texel(x0, y1),
+				d = texel(x1, y1);
+			auto dst = &out[((size_t)y * toWidth + x) * channels];
+			for (int i = 0; i < channels; ++i) {
+				float top = a[i] + (b[i] - a[i]) * tx,
+					bottom = c[i] + (d[i] - c[i]) * tx;
+				dst[i] = (unsigned char)(top + (bottom - top) * ty + .5f);
+			}
+		}
+	}
+	return out;
+}
+
+Texture Texture::generate(GLenum unitIndex, GLenum target) {
 	GLuint id{};
 	glGenTextures(1, &id);
-	return {id, unitIndex};
+	return {id, unitIndex, target};
 }
 
 Texture& Texture::bind() {
-	glActiveTexture(unitIndex);
-	glBindTexture(GL_TEXTURE_2D, id);
+	glState.bindTexture(unitIndex, target, id);
 	return *this;
 }
 
 Texture& Texture::unbind() {
-	glActiveTexture(unitIndex);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	glState.bindTexture(unitIndex, target, 0);
 	return *this;
 }
 
-void Texture::setParameter(GLenum pname, GLint param) {
-	glTexParameteri(GL_TEXTURE_2D, pname, param);
+void Texture::setParameter(GLenum pname, GLint param, GLenum target) {
+	glTexParameteri(target, pname, param);
+}
+
+static void setSwizzle(GLenum target, const PixelFormat& format) {
+	if (format.channels >= 3) return;
+	const GLint grey[] = {GL_RED, GL_RED, GL_RED, GL_ONE},
+		greyAlpha[] = {GL_RED, GL_RED, GL_RED, GL_GREEN};
+	glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA,
+		format.channels == 1 ? grey : greyAlpha);
+}
+
+GLsizei Texture::levelsFor(GLsizei width, GLsizei height) {
+	GLsizei levels = 1;
+	for (GLsizei size = width > height ? width : height; size > 1; size /= 2)
+		levels++;
+	return levels;
 }
 
-Texture& Texture::loadFromPath(const char* imagePath) {
+Texture& Texture::allocate(GLsizei width, GLsizei height,
+	const PixelFormat& format, GLsizei levels) {
+	if (levels <= 0) levels = levelsFor(width, height);
+	if (GLEXT_texture_storage) {
+		glTexStorage2D(GL_TEXTURE_2D, levels, format.internalFormat, width,
+			height);
+	} else {
+		for (GLsizei level = 0; level < levels; ++level) {
+			glTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, width,
+				height, 0, format.format, GL_UNSIGNED_BYTE, nullptr);
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+	setSwizzle(GL_TEXTURE_2D, format);
+	return *this;
+}
+
+Texture& Texture::upload(const void* pixels, GLsizei width, GLsizei height,
+	const PixelFormat& format, GLint level) {
+	// rows are tightly packed, 4 byte alignment only when they allow it.
+	glPixelStorei(GL_UNPACK_ALIGNMENT,
+		width * format.texelSize() % 4 ? 1 : 4);
+	glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format.format,
+		GL_UNSIGNED_BYTE, pixels);
+	return *this;
+}
+
+Texture& Texture::allocateLayers(GLsizei width, GLsizei height,
+	GLsizei layers, const PixelFormat& format, GLsizei levels) {
+	if (levels <= 0) levels = levelsFor(width, height);
+	if (GLEXT_texture_storage) {
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, format.internalFormat,
+			width, height, layers);
+	} else {
+		for (GLsizei level = 0; level < levels; ++level) {
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format.internalFormat,
+				width, height, layers, 0, format.format, GL_UNSIGNED_BYTE,
+				nullptr);
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+	setSwizzle(GL_TEXTURE_2D_ARRAY, format);
+	return *this;
+}
+
+Texture& Texture::uploadLayer(const void* pixels, GLsizei width,
+	GLsizei height, GLint layer, const PixelFormat& format, GLint level) {
+	glPixelStorei(GL_UNPACK_ALIGNMENT,
+		width * format.texelSize() % 4 ? 1 : 4);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1,
+		format.format, GL_UNSIGNED_BYTE, pixels);
+	return *this;
+}
+
+Texture& Texture::loadFromPath(const char* imagePath, bool expandRgb) {
 	int width{}, height{}, nrChannels{};
 	unsigned char* pixels = stbi_load(imagePath, &width, &height,
 		&nrChannels, 0);
@@ -32,9 +187,16 @@ Texture& Texture::loadFromPath(const char* imagePath) {
 		return *this;
 	}
 
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-		GL_UNSIGNED_BYTE, pixels);
+	auto format = PixelFormat::forChannels(nrChannels, expandRgb);
+	std::vector<unsigned char> expanded;
+	const unsigned char* data = pixels;
+	if (format.expandRgb) {
+		expanded.resize((size_t)width * height * 4);
+		expandRgbToRgba(pixels, expanded.data(), (size_t)width * height);
+		data = expanded.data();
+	}
+	allocate(width, height, format);
+	upload(data, width, height, format);
 	glGenerateMipmap(GL_TEXTURE_2D);
 	stbi_image_free(pixels);
 	return *this;
@@ -1,16 +1,65 @@
 #pragma once
 
+#include "glstate.hpp"
+
 #include <glad/glad.h>
 #include <stb_image.h>
 
+#include <cstddef>
 #include <iostream>
+#include <vector>
+
+// How an image with 1 to 4 8-bit channels is stored and uploaded. Grey and
+// grey-alpha are swizzled so they sample like the RGB(A) they stand for.
+struct PixelFormat {
+	// sized, e.g. GL_RGBA8.
+	GLenum internalFormat;
+	// of the uploaded pixels, e.g. GL_RGBA.
+	GLenum format;
+	// in the decoded image.
+	int channels;
+	// true if 3 channel images are expanded to RGBA on the cpu before the
+	// upload, see expandRgbToRgba.
+	bool expandRgb;
+	// bytes per uploaded texel.
+	int texelSize() const { return expandRgb ? 4 : channels; }
+
+	static PixelFormat forChannels(int channels, bool expandRgb = true);
+};
+
+// rgb to rgba with an opaque alpha, SSSE3 when the cpu has it.
+void expandRgbToRgba(const unsigned char* rgb, unsigned char* rgba,
+	size_t pixels);
+// bilinear, for fitting images into the layers of an array texture.
+std::vector<unsigned char> resizeImage(const unsigned char* pixels,
+	int width, int height, int channels, int toWidth, int toHeight);
 
 struct Texture {
 	GLuint id{};
 	GLenum unitIndex{};
-	static Texture generate(GLenum unitIndex);
+	// GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+	GLenum target = GL_TEXTURE_2D;
+	static Texture generate(GLenum unitIndex, GLenum target = GL_TEXTURE_2D);
 	Texture& bind();
 	Texture& unbind();
-	static void setParameter(GLenum pname, GLint param);
-	Texture& loadFromPath(const char* imagePath);
+	static void setParameter(GLenum pname, GLint param,
+		GLenum target = GL_TEXTURE_2D);
+	// mip levels down to 1x1.
+	static GLsizei levelsFor(GLsizei width, GLsizei height);
+	// storage for levels mips of the bound texture, the full chain if 0.
+	// Immutable (glTexStorage2D) where supported, so it can't be resized
+	// afterwards.
+	Texture& allocate(GLsizei width, GLsizei height, const PixelFormat& format,
+		GLsizei levels = 0);
+	// into allocated storage. pixels is an offset while a
+	// PIXEL_UNPACK_BUFFER is bound, and already expanded if the format
+	// says so.
+	Texture& upload(const void* pixels, GLsizei width, GLsizei height,
+		const PixelFormat& format, GLint level = 0);
+	// the same for GL_TEXTURE_2D_ARRAY, layers images of width x height.
+	Texture& allocateLayers(GLsizei width, GLsizei height, GLsizei layers,
+		const PixelFormat& format, GLsizei levels = 0);
+	Texture& uploadLayer(const void* pixels, GLsizei width, GLsizei height,
+		GLint layer, const PixelFormat& format, GLint level = 0);
+	Texture& loadFromPath(const char* imagePath, bool expandRgb = true);
 };
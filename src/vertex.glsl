@@ -1,22 +1,31 @@
 #version 330 core
 
+// per-frame data shared by every program, see FrameData in renderer.hpp.
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec2 resolution;
+	float time;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform float redValue;
-uniform float time;
-uniform vec3 camera;
-uniform vec2 resolution;
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
+// see VertexFormat::layerLocation, 0 for meshes without it.
+layout (location = 7) in float aLayer;
 
 out vec2 texCoord;
+flat out float layer;
 
 void main() {
-	mat4 transform = projection * view * model;
+	mat4 transform = viewProjection * model;
 
 	gl_Position = transform * (vec4(aPos, 1.0) + vec4(-.3, -.3, 0., 0.));
 	gl_Position.x *= resolution.y/resolution.x;
 	texCoord = aTexCoord;
+	layer = aLayer;
 }
@@ -0,0 +1,155 @@
+#include "vertexformat.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+static GLsizei attribSize(const VertexAttrib& attrib) {
+	switch (attrib.type) {
+	case AttribType::float32: return attrib.components * 4;
+	case AttribType::snorm10: return 4;
+	default: return (attrib.components + 1) / 2 * 4;
+	}
+}
+
+VertexFormat VertexFormat::create(const std::vector<VertexAttrib>& attribs) {
+	VertexFormat out;
+	out.attribs = attribs;
+	for (auto& attrib : attribs) {
+		out.offsets.push_back(out.stride);
+		out.stride += attribSize(attrib);
+		out.sourceStride += attrib.components;
+	}
+	return out;
+}
+
+const VertexFormat& VertexFormat::standard() {
+	static const auto format = create({
+		{0, 3, AttribType::float32},
+		{1, 2, AttribType::float32},
+	});
+	return format;
+}
+
+const VertexFormat& VertexFormat::compact() {
+	static const auto format = create({
+		{0, 3, AttribType::half},
+		{1, 2, AttribType::unorm16},
+	});
+	return format;
+}
+
+const VertexFormat& VertexFormat::quantized() {
+	static const auto format = create({
+		{0, 3, AttribType::snorm16},
+		{1, 2, AttribType::unorm16},
+	});
+	return format;
+}
+
+const VertexFormat& VertexFormat::layered() {
+	static const auto format = create({
+		{0, 3, AttribType::half},
+		{1, 2, AttribType::unorm16},
+		{layerLocation, 1, AttribType::half},
+	});
+	return format;
+}
+
+bool VertexFormat::normalized() const {
+	for (auto& attrib : attribs)
+		if (attrib.location == 0) return attrib.type == AttribType::snorm16;
+	return false;
+}
+
+std::vector<uint8_t> VertexFormat::encode(
+	const std::vector<float>& vertices) const {
+	size_t count = sourceStride ? vertices.size() / sourceStride : 0;
+	std::vector<uint8_t> out(count * stride);
+	for (size_t v = 0; v < count; ++v) {
+		const float* src = &vertices[v * sourceStride];
+		uint8_t* dst = &out[v * stride];
+		for (size_t a = 0; a < attribs.size(); ++a) {
+			auto& attrib = attribs[a];
+			uint8_t* p = dst + offsets[a];
+			if (attrib.type == AttribType::float32) {
+				memcpy(p, src, attrib.components * 4);
+			} else if (attrib.type == AttribType::snorm10) {
+				glm::vec4 n(0.f);
+				for (int c = 0; c < std::min(attrib.components, 4); ++c)
+					n[c] = src[c];
+				uint32_t packed = glm::packSnorm3x10_1x2(n);
+				memcpy(p, &packed, 4);
+			} else {
+				for (int c = 0; c < attrib.components; ++c) {
+					uint16_t packed =
+						attrib.type == AttribType::half ? glm::packHalf1x16(src[c])
+						: attrib.type == AttribType::snorm16 ? glm::packSnorm1x16(src[c])
+						: glm::packUnorm1x16(src[c]);
+					memcpy(p + c * 2, &packed, 2);
+				}
+			}
+			src += attrib.components;
+		}
+	}
+	return out;
+}
+
+void VertexFormat::apply() const {
+	for (size_t a = 0; a < attribs.size(); ++a) {
+		auto& attrib = attribs[a];
+		GLenum type = GL_FLOAT;
+		GLint size = attrib.components;
+		GLboolean normalize = GL_FALSE;
+		switch (attrib.type) {
+		case AttribType::float32: break;
+		case AttribType::half: type = GL_HALF_FLOAT; break;
+		case AttribType::snorm16: type = GL_SHORT; normalize = GL_TRUE; break;
+		case AttribType::unorm16:
+			type = GL_UNSIGNED_SHORT;
+			normalize = GL_TRUE;
+			break;
+		case AttribType::snorm10:
+			type = GL_INT_2_10_10_10_REV;
+			size = 4;
+			normalize = GL_TRUE;
+			break;
+		}
+		glEnableVertexAttribArray(attrib.location);
+		glVertexAttribPointer(attrib.location, size, type, normalize, stride,
+			(GLvoid*)(uintptr_t)offsets[a]);
+	}
+}
+
+glm::mat4 normalizePositions(std::vector<float>& vertices, size_t stride) {
+	glm::vec3 lo(INFINITY), hi(-INFINITY);
+	for (size_t i = 0; i + 2 < vertices.size(); i += stride) {
+		auto p = glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]);
+		lo = glm::min(lo, p);
+		hi = glm::max(hi, p);
+	}
+	if (lo.x > hi.x) return glm::mat4(1.f);
+	auto center = (lo + hi) * .5f;
+	// one scale for all axes keeps the quantization step uniform.
+	float extent = glm::max(glm::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) * .5f;
+	if (extent <= 0.f) extent = 1.f;
+	for (size_t i = 0; i + 2 < vertices.size(); i += stride)
+		for (int c = 0; c < 3; ++c)
+			vertices[i + c] = (vertices[i + c] - center[c]) / extent;
+	return glm::scale(glm::translate(glm::mat4(1.f), center),
+		glm::vec3(extent));
+}
+
+IndexData IndexData::pack(const std::vector<int>& indices, size_t vertexCount) {
+	IndexData out;
+	out.type = vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	out.bytes.resize(indices.size() * size(out.type));
+	if (out.type == GL_UNSIGNED_INT) {
+		memcpy(out.bytes.data(), indices.data(), out.bytes.size());
+	} else {
+		auto dst = (uint16_t*)out.bytes.data();
+		for (size_t i = 0; i < indices.size(); ++i) dst[i] = indices[i];
+	}
+	return out;
+}
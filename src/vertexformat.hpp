@@ -0,0 +1,79 @@
+#pragma once
+
+#include "glm.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class AttribType : uint8_t {
+	float32,
+	// 16 bit float, about 3 significant digits.
+	half,
+	// [-1, 1] and [0, 1] in 16 bits, values outside are clamped.
+	snorm16,
+	unorm16,
+	// xyz as 10 bit snorm and a 2 bit w in 4 bytes, for normals.
+	snorm10,
+};
+
+struct VertexAttrib {
+	GLuint location;
+	// floats the attribute takes in the source vertices.
+	GLint components;
+	AttribType type;
+	bool operator==(const VertexAttrib& other) const {
+		return location == other.location && components == other.components
+			&& type == other.type;
+	}
+};
+
+// Declares how interleaved float vertices, as kept in Mesh::vertices, are
+// packed into a vertex buffer. attributes are laid out in order, each
+// padded to 4 bytes; the padding component reads as 0 and is ignored by
+// shader inputs with fewer components.
+struct VertexFormat {
+	// texture array layer, per vertex. after InstanceData's locations.
+	static constexpr GLuint layerLocation = 7;
+	std::vector<VertexAttrib> attribs;
+	std::vector<GLsizei> offsets;
+	GLsizei stride = 0;
+	// floats per source vertex.
+	size_t sourceStride = 0;
+
+	static VertexFormat create(const std::vector<VertexAttrib>& attribs);
+	// float position and uv, 20 bytes.
+	static const VertexFormat& standard();
+	// half position and unorm16 uv, 12 bytes. uvs have to stay in [0, 1].
+	static const VertexFormat& compact();
+	// like compact with snorm16 positions, see normalizePositions.
+	static const VertexFormat& quantized();
+	// compact plus a half layer index, 16 bytes. 6 floats per source vertex.
+	static const VertexFormat& layered();
+
+	// true if positions (location 0) are snorm16 and have to be normalized.
+	bool normalized() const;
+	std::vector<uint8_t> encode(const std::vector<float>& vertices) const;
+	// points the bound VAO's attributes into the bound ARRAY_BUFFER.
+	void apply() const;
+	bool operator==(const VertexFormat& other) const {
+		return attribs == other.attribs;
+	}
+};
+
+// scales the first 3 floats of each vertex into [-1, 1] around their
+// bounds' center and returns the transform that scales them back.
+glm::mat4 normalizePositions(std::vector<float>& vertices, size_t stride);
+
+// indices in the narrowest type that can address vertexCount vertices:
+// GL_UNSIGNED_SHORT up to 65536, GL_UNSIGNED_INT above.
+struct IndexData {
+	GLenum type;
+	std::vector<uint8_t> bytes;
+	static IndexData pack(const std::vector<int>& indices, size_t vertexCount);
+	static GLsizei size(GLenum type) {
+		return type == GL_UNSIGNED_SHORT ? 2 : 4;
+	}
+};